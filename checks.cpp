@@ -0,0 +1,612 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "sequence.h"
+#include "tools/matrix.h"
+#include "tools/numbers/bigint.hpp"
+#include "tools/numbers/rational.h"
+#include "tools/numbers/tropical.h"
+
+/*
+    Self-checks for the fast paths of the library against the plain
+    algorithms they replace. Prints every failed check and returns non-zero
+    if there was one.
+*/
+
+int failures = 0;
+std::mt19937_64 generator(20261017);
+
+void check(bool passed, const std::string& what) {
+    if (!passed) {
+        std::cout << "ОШИБКА: " << what << '\n';
+        ++failures;
+    }
+}
+
+// A random number of the given number of 64-bit limbs and random sign. Every other one has all bits of its limbs set, for the longest carries
+BigInt random_bigint(size_t limbs) {
+    static const BigInt base("18446744073709551616");
+    const bool full = generator() % 2;
+    BigInt x(0);
+    for (size_t i = 0; i < limbs; ++i) {
+        x *= base;
+        x += full ? base - BigInt(1) : BigInt((long long) (generator() >> 1));
+    }
+    return generator() % 2 ? x : -x;
+}
+
+struct thresholds {
+    size_t karatsuba, toom3, ntt, newton;
+
+    static thresholds Current() {
+        return {KARATSUBA_THRESHOLD, TOOM3_THRESHOLD, NTT_THRESHOLD, NEWTON_DIVISION_THRESHOLD};
+    }
+
+    void Set() const {
+        KARATSUBA_THRESHOLD = karatsuba;
+        TOOM3_THRESHOLD = toom3;
+        NTT_THRESHOLD = ntt;
+        NEWTON_DIVISION_THRESHOLD = newton;
+    }
+};
+
+// Every multiplication and division algorithm, with the thresholds forced low, against the schoolbook method and Knuth's division
+void check_bigint_tiers() {
+    const thresholds defaults = thresholds::Current();
+    const size_t never = SIZE_MAX;
+    const thresholds reference = {never, never, never, never};
+    const std::vector<std::pair<std::string, thresholds>> tiers = {
+        {"Karatsuba", {4, never, never, never}},
+        {"Toom-3", {4, 12, never, never}},
+        {"NTT", {4, 12, 24, never}},
+        {"Newton", {never, never, never, 3}},
+        {"all", {4, 12, 24, 3}},
+        {"clamped", {1, 1, 1, 1}},
+    };
+    for (int test = 0; test < 40; ++test) {
+        const BigInt a = random_bigint(1 + generator() % 120), b = random_bigint(1 + generator() % 120);
+        reference.Set();
+        const BigInt product = a * b, dividend = a * b + a;
+        const BigInt quotient = dividend / b, remainder = dividend % b;
+        for (const auto& tier : tiers) {
+            tier.second.Set();
+            check(a * b == product, tier.first + ": a * b");
+            check(dividend / b == quotient && dividend % b == remainder, tier.first + ": (a b + a) / b");
+        }
+    }
+    defaults.Set();
+}
+
+// Exact division by divisors with factors of two, through Jebelean's method and through Newton's, and the division with remainder behind the checked Somos recurrence
+void check_divexact() {
+    const thresholds defaults = thresholds::Current();
+    const BigInt base("18446744073709551616");
+    for (int test = 0; test < 40; ++test) {
+        const BigInt a = random_bigint(1 + generator() % 60);
+        BigInt b = random_bigint(1 + generator() % 60) * BigInt(1LL << (generator() % 63));
+        for (size_t zeros = generator() % 3; zeros > 0; --zeros) {
+            b *= base;
+        }
+        for (size_t newton : {defaults.newton, size_t(3)}) {
+            NEWTON_DIVISION_THRESHOLD = newton;
+            BigInt quotient = a * b;
+            check(quotient.divexact(b) == a, "a b divexact b");
+            BigInt dividend = a * b + a, remainder;
+            quotient = dividend;
+            quotient.divmod(b, remainder);
+            check(quotient == dividend / b && remainder == dividend % b, "divmod against / and %");
+            check(quotient * b + remainder == dividend, "divmod: q b + r");
+        }
+    }
+    defaults.Set();
+
+    const std::vector<long long> somos4 = {1, 1, 1, 1, 2, 3, 7, 23, 59, 314, 1529, 8209, 83313, 620297};
+    SomosSequence<BigInt> checked(4, {1, 1}, {1, 1, 1, 1}), integral(4, {1, 1}, {1, 1, 1, 1}, true);
+    for (size_t n = 0; n < somos4.size(); ++n) {
+        check(checked[n] == BigInt(somos4[n]) && integral[n] == BigInt(somos4[n]), "Somos-4 term " + std::to_string(n));
+    }
+
+    // s_4 = (s_3 s_1 + s_2^2) / s_0 = 2 / 3
+    SomosSequence<BigInt> fractional(4, {1, 1}, {3, 1, 1, 1});
+    SomosSequence<long long> fractional_word(4, {1, 1}, {3, 1, 1, 1});
+    long long index = -1, word_index = -1;
+    try {
+        fractional[10];
+    } catch (const NonIntegralTerm& e) {
+        index = e.index;
+    }
+    try {
+        fractional_word[10];
+    } catch (const NonIntegralTerm& e) {
+        word_index = e.index;
+    }
+    check(index == 4 && word_index == 4, "Somos-4 3, 1, 1, 1 throws NonIntegralTerm at s_4");
+}
+
+// A rows x cols integer matrix of rank at most `rank`: the product of random factors with small entries, its rows scaled by factors of up to `scale_limbs` limbs, if any
+std::vector<std::vector<BigInt>> random_low_rank(size_t rows, size_t cols, size_t rank, size_t scale_limbs) {
+    std::vector<std::vector<long long>> left(rows, std::vector<long long>(rank)), right(rank, std::vector<long long>(cols));
+    for (auto& line : left)
+        for (auto& x : line)
+            x = (long long) (generator() % 11) - 5;
+    for (auto& line : right)
+        for (auto& x : line)
+            x = (long long) (generator() % 11) - 5;
+    std::vector<std::vector<BigInt>> entries(rows, std::vector<BigInt>(cols, BigInt(0)));
+    for (size_t i = 0; i < rows; ++i) {
+        const BigInt scale = scale_limbs == 0 ? BigInt(1) : random_bigint(1 + generator() % scale_limbs);
+        for (size_t j = 0; j < cols; ++j) {
+            for (size_t t = 0; t < rank; ++t)
+                entries[i][j] += BigInt(left[i][t] * right[t][j]);
+            entries[i][j] *= scale;
+        }
+    }
+    return entries;
+}
+
+template<typename T>
+std::vector<std::vector<T>> convert(const std::vector<std::vector<BigInt>>& entries) {
+    std::vector<std::vector<T>> result;
+    for (const auto& line : entries) {
+        result.emplace_back();
+        for (const BigInt& x : line)
+            result.back().push_back(T(x));
+    }
+    return result;
+}
+
+// ModularRank, with and without the exact verification, against GaussRank over the rationals
+void check_modular_rank() {
+    for (int test = 0; test < 60; ++test) {
+        const size_t rows = 1 + generator() % 12, cols = 1 + generator() % 12, rank = generator() % (std::min(rows, cols) + 1);
+        const auto big = random_low_rank(rows, cols, rank, 3);
+        const auto rational = convert<Rational>(big);
+        const size_t expected = Matrix<Rational>(rational).GaussRank();
+        const Matrix<BigInt> m(big);
+        check(m.ModularRank() == expected, "ModularRank of a BigInt matrix");
+        check(m.ModularRank(1, true) == expected, "verified ModularRank of a BigInt matrix");
+        check(Matrix<Rational>(rational).ModularRank(1, true) == expected, "verified ModularRank of a Rational matrix");
+
+        // entries close to 2^62, which overflow any word arithmetic on them: rows past `rank` repeat earlier ones up to sign
+        std::vector<std::vector<long long>> words(rows, std::vector<long long>(cols, 0));
+        for (size_t i = 0; i < rows && rank > 0; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                if (i < rank)
+                    words[i][j] = (long long) (generator() >> 2) - (1LL << 61);
+                else
+                    words[i][j] = i % 2 ? words[i % rank][j] : -words[i % rank][j];
+            }
+        }
+        std::vector<std::vector<Rational>> exact(rows, std::vector<Rational>(cols));
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                exact[i][j] = Rational(words[i][j]);
+        const size_t word_expected = Matrix<Rational>(exact).GaussRank();
+        check(Matrix<long long>(words).ModularRank() == word_expected, "ModularRank of a long long matrix");
+        check(Matrix<long long>(words).ModularRank(1, true) == word_expected, "verified ModularRank of a long long matrix");
+    }
+}
+
+// TropicalDeterminant and TropicallySingular against the maximum over all permutations. Entries are small, so that the maximum is often attained twice
+void check_tropical() {
+    for (int test = 0; test < 300; ++test) {
+        const size_t n = 1 + generator() % 6;
+        std::vector<std::vector<Tropical<long long>>> entries(n, std::vector<Tropical<long long>>(n));
+        for (auto& line : entries)
+            for (auto& x : line)
+                if (generator() % 5 != 0)
+                    x = Tropical<long long>((long long) (generator() % 9) - 4);
+
+        std::vector<size_t> perm(n);
+        for (size_t i = 0; i < n; ++i)
+            perm[i] = i;
+        Tropical<long long> best;
+        size_t attained = 0;
+        do {
+            bool finite = true;
+            long long weight = 0;
+            for (size_t i = 0; i < n && finite; ++i) {
+                finite = !entries[i][perm[i]].IsZero();
+                weight += finite ? entries[i][perm[i]].Value() : 0;
+            }
+            if (!finite)
+                continue;
+            if (best.IsZero() || weight > best.Value()) {
+                best = Tropical<long long>(weight);
+                attained = 1;
+            } else if (weight == best.Value()) {
+                ++attained;
+            }
+        } while (std::next_permutation(perm.begin(), perm.end()));
+
+        const Matrix<Tropical<long long>> m(entries);
+        check(m.TropicalDeterminant() == best, "TropicalDeterminant of a " + std::to_string(n) + "x" + std::to_string(n) + " matrix");
+        check(m.TropicallySingular() == (attained != 1), "TropicallySingular of a " + std::to_string(n) + "x" + std::to_string(n) + " matrix");
+    }
+}
+
+// A sequence given by a formula for its terms
+template<typename T>
+class FormulaSequence : public Sequence<T> {
+    std::function<T(long long)> formula;
+public:
+    FormulaSequence(std::function<T(long long)> formula) : formula(std::move(formula)) {
+    }
+
+    T operator [] (long long n) override {
+        return formula(n);
+    }
+};
+
+// Matrix(sequence, size, type) for every type and size up to 10, on one and on several threads, against the definitions of the matrices through the terms of the sequence
+template<typename T>
+void check_sequence_matrix(Sequence<T>& sequence, const std::string& name) {
+    const size_t threads = ELIMINATION_THREADS;
+    for (size_t threads_used : {size_t(1), size_t(4)}) {
+        ELIMINATION_THREADS = threads_used;
+        for (int64_t type = 0; type < 4; ++type) {
+            for (int64_t size = 0; size <= 10; ++size) {
+                const Matrix<T> built(sequence, size, type);
+                bool same = built.Rows() == (size_t) size && built.Cols() == (size_t) size;
+                for (int64_t m = 0; m < size && same; ++m) {
+                    for (int64_t n = 0; n < size && same; ++n) {
+                        const T expected = type == 2 ? sequence[m + n] : type == 3 ? sequence[m - n] : sequence[m + n] * sequence[m - n];
+                        same = built[m][n] == expected;
+                    }
+                }
+                check(same, "M" + std::to_string(type) + " " + std::to_string(size) + "x" + std::to_string(size) + " of " + name + " on " + std::to_string(threads_used) + " threads");
+            }
+        }
+    }
+    ELIMINATION_THREADS = threads;
+}
+
+// The sequence constructor over BigInt, Rational and Tropical, on sequences with an even, an odd and no reflection
+void check_sequence_matrices() {
+    const BigInt big = random_bigint(3);
+    FormulaSequence<BigInt> big_even([&](long long n) { return big * BigInt(n * n + 1); });
+    FormulaSequence<BigInt> big_odd([&](long long n) { return big * BigInt(n * n * n - 7 * n); });
+    FormulaSequence<BigInt> big_plain([&](long long n) { return big * BigInt(n * n * n + 2 * n * n + 5); });
+    SomosSequence<BigInt> big_somos4(4, {1, 1}, {1, 1, 1, 1}, true), big_somos5(5, {1, 1}, {1, 1, 1, 1, 1}, true);
+    check_sequence_matrix(big_even, "BigInt n^2 + 1");
+    check_sequence_matrix(big_odd, "BigInt n^3 - 7n");
+    check_sequence_matrix(big_plain, "BigInt n^3 + 2n^2 + 5");
+    check_sequence_matrix(big_somos4, "BigInt Somos-4");
+    check_sequence_matrix(big_somos5, "BigInt Somos-5");
+
+    FormulaSequence<Rational> rational_even([](long long n) { return Rational(1, n * n + 1); });
+    FormulaSequence<Rational> rational_odd([](long long n) { return Rational(n, n * n + 3); });
+    FormulaSequence<Rational> rational_plain([](long long n) { return Rational(n + 1, n * n + 5); });
+    SomosSequence<Rational> rational_somos5(5, {1, 1}, {1, 1, 1, 1, 1});
+    check_sequence_matrix(rational_even, "Rational 1 / (n^2 + 1)");
+    check_sequence_matrix(rational_odd, "Rational n / (n^2 + 3)");
+    check_sequence_matrix(rational_plain, "Rational (n + 1) / (n^2 + 5)");
+    check_sequence_matrix(rational_somos5, "Rational Somos-5");
+
+    FormulaSequence<Tropical<long long>> tropical_even([](long long n) { return Tropical<long long>(n * n); });
+    FormulaSequence<Tropical<long long>> tropical_plain([](long long n) { return n % 3 == 0 ? Tropical<long long>() : Tropical<long long>(n * n * n - n); });
+    check_sequence_matrix(tropical_even, "Tropical n^2");
+    check_sequence_matrix(tropical_plain, "Tropical n^3 - n");
+}
+
+// RankProfile over the integers, which must not divide by the pivots, and over the rationals, against the ranks of the leading submatrices
+void check_rank_profile() {
+    const Matrix<BigInt> small(std::vector<std::vector<BigInt>>{{2, 4}, {1, 2}});
+    check(small.RankProfile() == std::vector<size_t>({0, 1, 1}), "RankProfile of [[2, 4], [1, 2]]");
+
+    for (int test = 0; test < 60; ++test) {
+        const size_t rows = 1 + generator() % 10, cols = 1 + generator() % 10;
+        const auto entries = random_low_rank(rows, cols, generator() % (std::min(rows, cols) + 1), 2);
+        const Matrix<Rational> rational(convert<Rational>(entries));
+        std::vector<size_t> expected(1, 0);
+        for (size_t n = 1; n <= std::min(rows, cols); ++n) {
+            std::vector<size_t> leading(n);
+            for (size_t i = 0; i < n; ++i)
+                leading[i] = i;
+            expected.push_back(Matrix<Rational>(rational, leading, leading).GaussRank());
+        }
+        std::vector<size_t> square(std::min(rows, cols));
+        for (size_t i = 0; i < square.size(); ++i)
+            square[i] = i;
+        const Matrix<BigInt> big(entries);
+        check(big.RankProfile() == expected, "RankProfile of a BigInt matrix");
+        check(big.RankProfile().back() == Matrix<BigInt>(big, square, square).Rank(), "RankProfile().back() against Rank() of a BigInt matrix");
+        check(rational.RankProfile() == expected, "RankProfile of a Rational matrix");
+        check(rational.RankProfile().back() == Matrix<Rational>(rational, square, square).Rank(), "RankProfile().back() against Rank() of a Rational matrix");
+    }
+}
+
+// RankAtMost at the rank and one below it, and every kernel vector it returns multiplied by the matrix
+template<typename T>
+void check_rank_at_most(const Matrix<T>& m, const std::string& name) {
+    const size_t rank = m.Rank();
+    std::vector<std::vector<T>> kernel;
+    check(m.RankAtMost(rank, &kernel), "RankAtMost(Rank()) of " + name);
+    check(rank == 0 || !m.RankAtMost(rank - 1), "RankAtMost(Rank() - 1) of " + name);
+    check(kernel.size() == m.Cols() - rank, "kernel size of " + name);
+    for (const auto& x : kernel) {
+        bool vanishes = true, nonzero = false;
+        for (size_t i = 0; i < m.Rows(); ++i) {
+            T product = T(0);
+            for (size_t j = 0; j < m.Cols(); ++j)
+                product += m[i][j] * x[j];
+            vanishes = vanishes && product == T(0);
+        }
+        for (const T& entry : x)
+            nonzero = nonzero || entry != T(0);
+        check(vanishes && nonzero, "kernel vector of " + name);
+    }
+}
+
+void check_rank_certificates() {
+    check_rank_at_most(Matrix<BigInt>(std::vector<std::vector<BigInt>>{{2, 4}, {1, 2}}), "[[2, 4], [1, 2]]");
+    SomosSequence<BigInt> somos5(5, {1, 1}, {1, 1, 1, 1, 1}, true);
+    check_rank_at_most(Matrix<BigInt>(somos5, 16, 0), "M0 of Somos-5");
+
+    for (int test = 0; test < 60; ++test) {
+        const size_t rows = 1 + generator() % 10, cols = 1 + generator() % 10;
+        const auto entries = random_low_rank(rows, cols, generator() % (std::min(rows, cols) + 1), 2);
+        check_rank_at_most(Matrix<BigInt>(entries), "a BigInt matrix");
+        check_rank_at_most(Matrix<Rational>(convert<Rational>(entries)), "a Rational matrix");
+        const auto unscaled = random_low_rank(rows, cols, generator() % (std::min(rows, cols) + 1), 0);
+        std::vector<std::vector<long long>> words(rows, std::vector<long long>(cols));
+        for (size_t i = 0; i < rows; ++i)
+            for (size_t j = 0; j < cols; ++j)
+                words[i][j] = unscaled[i][j].to_long_long();
+        check_rank_at_most(Matrix<long long>(words), "a long long matrix");
+    }
+}
+
+// Every row kernel the CPU can run against the scalar loop, and the dispatchers, on lengths that are not multiples of the vector width
+void check_row_kernels() {
+    std::vector<std::pair<std::string, void (*)(double*, const double*, double, size_t)>> double_kernels = {{"axpy_double", axpy_double}};
+    std::vector<std::pair<std::string, void (*)(uint64_t*, const uint64_t*, uint64_t, uint64_t, uint64_t, size_t)>> mod32_kernels;
+#ifdef ROW_KERNELS_X86
+    if (__builtin_cpu_supports("avx2")) {
+        double_kernels.emplace_back("axpy_double_avx2", axpy_double_avx2);
+        mod32_kernels.emplace_back("axpy_mod32_avx2", axpy_mod32_avx2);
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        double_kernels.emplace_back("axpy_double_avx512", axpy_double_avx512);
+        mod32_kernels.emplace_back("axpy_mod32_avx512", axpy_mod32_avx512);
+    }
+#endif
+    std::vector<size_t> sizes;
+    for (size_t size = 0; size <= 40; ++size)
+        sizes.push_back(size);
+    sizes.push_back(257);
+
+    for (size_t size : sizes) {
+        std::vector<double> x(size), y(size);
+        for (size_t i = 0; i < size; ++i) {
+            x[i] = std::ldexp((double) (generator() >> 11), -20) - 4096;
+            y[i] = std::ldexp((double) (generator() >> 11), -30);
+        }
+        const double coef = std::ldexp((double) (generator() >> 11), -50);
+        std::vector<double> expected = x;
+        axpy_double_scalar(expected.data(), y.data(), coef, size);
+        for (const auto& kernel : double_kernels) {
+            std::vector<double> result = x;
+            kernel.second(result.data(), y.data(), coef, size);
+            check(result == expected, kernel.first + " of length " + std::to_string(size));
+        }
+
+        for (uint64_t p : {3ULL, 65521ULL, 2147483647ULL, 4294967291ULL, 2305843009213693951ULL, 9223372036854775783ULL}) {
+            std::vector<uint64_t> a(size), b(size);
+            for (size_t i = 0; i < size; ++i) {
+                a[i] = generator() % p;
+                b[i] = i % 5 == 0 ? p - 1 : generator() % p;
+            }
+            const uint64_t w = size % 3 == 0 ? p - 1 : generator() % p;
+            std::vector<uint64_t> reference = a;
+            for (size_t i = 0; i < size; ++i)
+                reference[i] = sub_mod(a[i], mul_mod(w, b[i], p), p);
+            std::vector<uint64_t> result = a;
+            axpy_mod(result.data(), b.data(), w, p, size);
+            check(result == reference, "axpy_mod of length " + std::to_string(size) + " modulo " + std::to_string(p));
+            if (p >> 32 != 0)
+                continue;
+            for (const auto& kernel : mod32_kernels) {
+                result = a;
+                kernel.second(result.data(), b.data(), w, (w << 32) / p, p, size);
+                check(result == reference, kernel.first + " of length " + std::to_string(size) + " modulo " + std::to_string(p));
+            }
+        }
+    }
+}
+
+// The blocked modular_rank, with panels and tiles smaller than the matrix, against plain elimination
+void check_modular_rank_kernel() {
+    const size_t panel = MODULAR_PANEL, tile = MODULAR_TILE;
+    MODULAR_PANEL = 5;
+    MODULAR_TILE = 7;
+    for (int test = 0; test < 40; ++test) {
+        const size_t rows = 1 + generator() % 30, cols = 1 + generator() % 30, rank = generator() % (std::min(rows, cols) + 1);
+        for (uint64_t p : {65521ULL, 2305843009213693951ULL}) {
+            std::vector<uint64_t> left(rows * rank), right(rank * cols), m(rows * cols, 0);
+            for (auto& x : left)
+                x = generator() % p;
+            for (auto& x : right)
+                x = generator() % p;
+            for (size_t i = 0; i < rows; ++i)
+                for (size_t j = 0; j < cols; ++j)
+                    for (size_t t = 0; t < rank; ++t)
+                        m[i * cols + j] = add_mod(m[i * cols + j], mul_mod(left[i * rank + t], right[t * cols + j], p), p);
+
+            std::vector<uint64_t> plain = m;
+            size_t expected = 0;
+            for (size_t c = 0; c < cols && expected < rows; ++c) {
+                size_t pivot = expected;
+                while (pivot < rows && plain[pivot * cols + c] == 0)
+                    ++pivot;
+                if (pivot == rows)
+                    continue;
+                std::swap_ranges(plain.begin() + pivot * cols, plain.begin() + (pivot + 1) * cols, plain.begin() + expected * cols);
+                const uint64_t inverse = inverse_mod(plain[expected * cols + c], p);
+                for (size_t i = expected + 1; i < rows; ++i) {
+                    const uint64_t coef = mul_mod(plain[i * cols + c], inverse, p);
+                    for (size_t k = c; k < cols; ++k)
+                        plain[i * cols + k] = sub_mod(plain[i * cols + k], mul_mod(coef, plain[expected * cols + k], p), p);
+                }
+                ++expected;
+            }
+            std::vector<size_t> pivot_rows;
+            check(modular_rank(m.data(), rows, cols, p, pivot_rows) == expected && pivot_rows.size() == expected, "modular_rank of a " + std::to_string(rows) + "x" + std::to_string(cols) + " matrix modulo " + std::to_string(p));
+        }
+    }
+    MODULAR_PANEL = panel;
+    MODULAR_TILE = tile;
+}
+
+// ComputeStructuredRank of the Hankel and Toeplitz matrices of sizes up to 16 against Rank() of the built matrix, for the terms s_n = terms[n + 32]
+void check_structured_rank(const std::vector<Zp<1000000007>>& terms, const std::string& name) {
+    FormulaSequence<Zp<1000000007>> sequence([&](long long n) { return terms[n + 32]; });
+    for (int64_t size = 1; size <= 16; ++size) {
+        for (int64_t type = 2; type < 4; ++type) {
+            // without the progress messages of ComputeStructuredRank
+            std::streambuf* const output = std::cout.rdbuf(nullptr);
+            const size_t structured = sequence.ComputeStructuredRank(size, type);
+            std::cout.rdbuf(output);
+            std::cout.clear();
+            check(structured == Matrix<Zp<1000000007>>(sequence, size, type).Rank(), "ComputeStructuredRank of M" + std::to_string(type) + " " + std::to_string(size) + "x" + std::to_string(size) + " of " + name);
+        }
+    }
+}
+
+/*
+    Random linear recurrences of order L, for sizes below L, between L and
+    2L and above 2L, and sparse sequences, whose prefixes have a linear
+    complexity far from half their length and different from that of the
+    reversed prefixes of the Toeplitz matrices.
+*/
+void check_structured_ranks() {
+    using Field = Zp<1000000007>;
+    for (size_t length : {1, 2, 3, 5, 8}) {
+        std::vector<Field> coefs(length), terms;
+        for (Field& c : coefs)
+            c = Field(generator() % 1000000006 + 1);
+        while (terms.size() < 64) {
+            Field next(0);
+            if (terms.size() < length)
+                next = Field(generator() % 1000000007);
+            for (size_t j = 0; j < length && terms.size() >= length; ++j)
+                next += coefs[j] * terms[terms.size() - 1 - j];
+            terms.push_back(next);
+        }
+        check_structured_rank(terms, "a recurrence of order " + std::to_string(length));
+    }
+    for (int test = 0; test < 20; ++test) {
+        std::vector<Field> terms(64, Field(0));
+        for (Field& x : terms)
+            if (generator() % 6 == 0)
+                x = Field(generator() % 1000000006 + 1);
+        check_structured_rank(terms, "a sparse sequence");
+    }
+}
+
+// DivisionFreeDeterminant against BareissDeterminant, on full rank and singular integer matrices and ones whose leading entry is zero
+void check_division_free_determinant() {
+    for (int test = 0; test < 60; ++test) {
+        const size_t n = 1 + generator() % 8;
+        std::vector<std::vector<BigInt>> entries(n, std::vector<BigInt>(n));
+        for (auto& line : entries)
+            for (auto& x : line)
+                x = random_bigint(1 + generator() % 2);
+        if (test % 3 == 1)
+            entries = random_low_rank(n, n, generator() % n, 2);
+        if (test % 3 == 2)
+            entries[0][0] = BigInt(0);
+        const Matrix<BigInt> m(entries);
+        check(m.DivisionFreeDeterminant() == m.BareissDeterminant(), "DivisionFreeDeterminant of a " + std::to_string(n) + "x" + std::to_string(n) + " matrix");
+    }
+}
+
+// Lift against the terms computed over the integers, with just enough primes, and on a sequence with a term 0 over Z, whose VanishingTerm every prime raises
+void check_lift() {
+    const long long left = -12, right = 28;
+    for (size_t k : {4, 5}) {
+        const SomosSequence<BigInt> somos(k, {1, 1}, std::vector<BigInt>(k, BigInt(1)), true);
+        SomosSequence<BigInt> exact = somos;
+        BigInt largest(0);
+        for (long long n = left; n < right; ++n)
+            largest = std::max(largest, exact[n] < BigInt(0) ? -exact[n] : exact[n]);
+        // |s_n| < 2^(60 * primes - 1)
+        size_t primes = 0;
+        for (BigInt bound(1); bound <= largest * BigInt(2); bound *= BigInt(1LL << 60))
+            ++primes;
+        const std::vector<BigInt> lifted = somos.Lift(left, right, primes);
+        bool same = lifted.size() == (size_t) (right - left);
+        for (long long n = left; n < right && same; ++n)
+            same = lifted[n - left] == exact[n];
+        check(same, "Lift of Somos-" + std::to_string(k) + " on " + std::to_string(primes) + " primes");
+    }
+
+    // s_n s_{n-4} = s_{n-1} s_{n-3} - s_{n-2}^2 from four ones has s_4 = 0
+    const SomosSequence<BigInt> vanishing(4, {1, -1}, {1, 1, 1, 1}, true);
+    const std::vector<BigInt> before = vanishing.Lift(0, 4, 2);
+    check(before == std::vector<BigInt>(4, BigInt(1)), "Lift before the vanishing term");
+    long long index = -1;
+    try {
+        vanishing.Lift(0, 6, 2);
+    } catch (const VanishingTerm& e) {
+        index = e.index;
+    }
+    check(index == 4, "VanishingTerm of Lift past a term 0 over Z");
+}
+
+// LazyDeterminant of matrices and of views with shuffled rows and columns, on one and on several threads, against BareissDeterminant. Some entries are zero, so that partial products vanish
+void check_lazy_determinant() {
+    const size_t threads = ELIMINATION_THREADS;
+    for (int test = 0; test < 60; ++test) {
+        const size_t n = generator() % 8;
+        std::vector<std::vector<BigInt>> entries(n + 2, std::vector<BigInt>(n + 2));
+        for (auto& line : entries)
+            for (auto& x : line)
+                x = generator() % 4 == 0 ? BigInt(0) : random_bigint(1);
+        if (test % 3 == 1 && n > 0)
+            entries = random_low_rank(n + 2, n + 2, generator() % n, 1);
+        const Matrix<BigInt> m(entries);
+        std::vector<size_t> rows(n + 2), cols(n + 2);
+        for (size_t i = 0; i < n + 2; ++i)
+            rows[i] = cols[i] = i;
+        std::shuffle(rows.begin(), rows.end(), generator);
+        std::shuffle(cols.begin(), cols.end(), generator);
+        rows.resize(n);
+        cols.resize(n);
+        const Matrix<BigInt> square(m, rows, rows), sub(m, rows, cols);
+        for (size_t threads_used : {size_t(1), size_t(4)}) {
+            ELIMINATION_THREADS = threads_used;
+            const std::string size = std::to_string(n) + "x" + std::to_string(n) + " on " + std::to_string(threads_used) + " threads";
+            check(square.LazyDeterminant() == square.BareissDeterminant(), "LazyDeterminant of a " + size);
+            check(MatrixView<BigInt>(m, rows, cols).LazyDeterminant() == sub.BareissDeterminant(), "LazyDeterminant of a view " + size);
+        }
+    }
+    ELIMINATION_THREADS = threads;
+}
+
+int main() {
+    check_bigint_tiers();
+    check_divexact();
+    check_modular_rank();
+    check_tropical();
+    check_sequence_matrices();
+    check_rank_profile();
+    check_rank_certificates();
+    check_row_kernels();
+    check_modular_rank_kernel();
+    check_structured_ranks();
+    check_division_free_determinant();
+    check_lift();
+    check_lazy_determinant();
+
+    if (failures != 0) {
+        std::cout << "Проверок не пройдено: " << failures << '\n';
+        return 1;
+    }
+    std::cout << "Все проверки пройдены\n";
+}
@@ -4,11 +4,55 @@
 #include <iostream>
 #include <vector>
 #include "tools/matrix.h"
+#include "tools/numbers/zp.h"
 #include "w_elliptic/src/w_elliptic.hpp"
 
 
 // T is a type of sequence elements. May be integer, real or complex
 
+// Thrown when a term of a recurrence with division vanishes, so that the terms past it cannot be computed. Over Zp it means p divides the term and the prime has to be skipped
+class VanishingTerm : public std::runtime_error {
+public:
+    const long long index;
+
+    VanishingTerm(long long index) : std::runtime_error("Zero element in sequence"), index(index) {
+    }
+};
+
+// Thrown when a term of an integer recurrence with division is not an integer
+class NonIntegralTerm : public std::runtime_error {
+public:
+    const long long index;
+
+    NonIntegralTerm(long long index) : std::runtime_error("Non-integral element in sequence"), index(index) {
+    }
+};
+
+// Computes num /= den for the term with the given index of a recurrence over BigInt, throwing NonIntegralTerm if den does not divide num
+template<typename T>
+auto checked_divide(T& num, const T& den, long long index, int) -> decltype(num.divmod(den, num), void()) {
+    T remainder;
+    num.divmod(den, remainder);
+    if (remainder != 0) {
+        throw NonIntegralTerm(index);
+    }
+}
+
+// The same over built-in integers
+template<typename T>
+auto checked_divide(T& num, const T& den, long long index, long) -> decltype(num % den, void()) {
+    if (num % den != 0) {
+        throw NonIntegralTerm(index);
+    }
+    num /= den;
+}
+
+// Fields (Rational, Zp, floating point) divide exactly
+template<typename T>
+void checked_divide(T& num, const T& den, long long, ...) {
+    num = num / den;
+}
+
 template <typename T>
 class Sequence {
 public:
@@ -24,6 +68,15 @@ public:
     virtual T operator [] (long long n) {
         return T(0);
     }
+
+    // Terms s_lo, ..., s_{hi - 1} in one array, for readers of many terms such as the matrix constructors. Sequences with a cache override it with a copy
+    virtual std::vector<T> Materialize(long long lo, long long hi) {
+        std::vector<T> terms;
+        for (long long i = lo; i < hi; ++i) {
+            terms.push_back((*this)[i]);
+        }
+        return terms;
+    }
     
     void Print(int64_t left, int64_t right) {
         for (int64_t i = left; i < right; ++i) {
@@ -36,21 +89,108 @@ public:
     	Matrix<T> M(*this, matrix_size, matrix_type);
     	std::cout << "Вычисляю ранг матрицы M" << matrix_type << "...\n";
     	//std::cout << M0 << '\n';
-    	size_t rank = M.GaussRank();
+    	size_t rank = std::move(M).Rank();
+    	std::cout << "Ранг матрицы равен\t" << rank << '\n';
+    	return rank;
+    }
+
+    /*
+        Rank without building the matrix, for the Hankel (2) and Toeplitz (3)
+        matrices only: they are determined by the 2n - 1 terms of the
+        sequence they run through, and their rank comes from Berlekamp-Massey
+        in O(n^2). M0 and M1 have no such structure, and rings that are not
+        fields have no Berlekamp-Massey, so both go to ComputeRank().
+    */
+    size_t ComputeStructuredRank(int64_t matrix_size, int64_t matrix_type = 0) {
+    	if (matrix_type < 0 || matrix_type > 3) {
+    	    throw std::invalid_argument("matrix_type is not 0, 1, 2 or 3");
+    	}
+    	if (!is_field<T>::value || matrix_type < 2) {
+    	    return ComputeRank(matrix_size, matrix_type);
+    	}
+    	std::cout << "Вычисляю ранг матрицы M" << matrix_type << " размера " << matrix_size << 'x' << matrix_size << " по последовательности...\n";
+    	int64_t lo, hi;
+    	sequence_matrix_range(matrix_size, matrix_type, lo, hi);
+    	std::vector<T> terms = Materialize(lo, hi);
+    	// the Toeplitz matrix is the Hankel matrix of s[size - 1 - k] with its rows reversed
+    	if (matrix_type == 3) {
+    	    std::reverse(terms.begin(), terms.end());
+    	}
+    	size_t rank = hankel_rank(terms);
+    	std::cout << "Ранг матрицы равен\t" << rank << '\n';
+    	return rank;
+    }
+
+    // Confirms rank <= rank_bound with early exit (see Matrix::RankAtMost), reporting the size of the kernel certificate
+    bool CheckRank(int64_t matrix_size, size_t rank_bound, int64_t matrix_type = 0) {
+    	std::cout << "Инициализирую матрицу M" << matrix_type << " размера " << matrix_size << 'x' << matrix_size << ":\n";
+    	Matrix<T> M(*this, matrix_size, matrix_type);
+    	std::cout << "Проверяю, что ранг матрицы M" << matrix_type << " не превосходит " << rank_bound << "...\n";
+    	std::vector<std::vector<T>> kernel;
+    	bool at_most = M.RankAtMost(rank_bound, &kernel);
+    	if (at_most) {
+    	    std::cout << "Ранг матрицы не превосходит\t" << rank_bound << ", размерность ядра\t" << kernel.size() << '\n';
+    	} else {
+    	    std::cout << "Ранг матрицы больше\t" << rank_bound << '\n';
+    	}
+    	return at_most;
+    }
+
+    // Ranks of the matrices of every size up to matrix_size, from a single elimination (see Matrix::RankProfile)
+    std::vector<size_t> ComputeRankProfile(int64_t matrix_size, int64_t matrix_type = 0) {
+    	std::cout << "Инициализирую матрицу M" << matrix_type << " размера " << matrix_size << 'x' << matrix_size << ":\n";
+    	Matrix<T> M(*this, matrix_size, matrix_type);
+    	std::cout << "Вычисляю ранги ведущих подматриц M" << matrix_type << "...\n";
+    	std::vector<size_t> ranks = M.RankProfile();
+    	for (size_t n = 1; n < ranks.size(); ++n) {
+    	    std::cout << "Ранг матрицы размера " << n << 'x' << n << " равен\t" << ranks[n] << '\n';
+    	}
+    	return ranks;
+    }
+
+    // Same as ComputeRank, but modulo `primes` random 61-bit primes (see Matrix::ModularRank)
+    size_t ComputeModularRank(int64_t matrix_size, int64_t matrix_type = 0, size_t primes = 3, bool verify = false) {
+    	std::cout << "Инициализирую матрицу M" << matrix_type << " размера " << matrix_size << 'x' << matrix_size << ":\n";
+    	Matrix<T> M(*this, matrix_size, matrix_type);
+    	std::cout << "Вычисляю ранг матрицы M" << matrix_type << " по " << primes << " простым модулям...\n";
+    	double error = 0;
+    	size_t rank = M.ModularRank(primes, verify, &error);
     	std::cout << "Ранг матрицы равен\t" << rank << '\n';
+    	std::cout << "Вероятность ошибки не превосходит\t" << error << '\n';
     	return rank;
     }
 };
 
+/*
+    Somos-k recurrence s_n s_{n-k} = sum of coefs[j-1] s_{n-j} s_{n-k+j},
+    j = 1..k/2. Over an integer type each division is checked and a term
+    that is not an integer throws NonIntegralTerm, unless the sequence is
+    declared integral (e.g. unit initial values and coefficients for which
+    the Laurent phenomenon applies): then the remainder is not computed and
+    the faster exact division is used.
+*/
 template <typename T>
 class SomosSequence : public Sequence<T> {
     size_t k;
     std::vector<T> coefs;
+    bool integral;
+
+    // Divides the numerator of the term with the given index by the term k steps back
+    void Divide(T& num, const T& den, long long index) const {
+        if (integral) {
+            exact_divide(num, den, 0);
+        } else {
+            checked_divide(num, den, index, 0);
+        }
+    }
 public:
     using Sequence<T>::forward_sequence;
     using Sequence<T>::backward_sequence;
 
-    SomosSequence (size_t k, const std::vector<T>& coefs, const std::vector<T>& initial_values) : k(k), coefs(coefs) {
+    template <typename U>
+    friend class SomosSequence;
+
+    SomosSequence (size_t k, const std::vector<T>& coefs, const std::vector<T>& initial_values, bool integral = false) : k(k), coefs(coefs), integral(integral) {
         if (k != initial_values.size()) {
             throw std::invalid_argument("Somos-k number k differs from the number of initial values");
         }
@@ -65,6 +205,40 @@ public:
         }
     }
 
+    // The same recurrence with coefficients and initial values converted to T, e.g. reduced into Zp
+    template <typename U>
+    explicit SomosSequence (const SomosSequence<U>& other) : k(other.k), coefs(other.coefs.begin(), other.coefs.end()), integral(other.integral) {
+        for (size_t i = 0; i < k; ++i) {
+            forward_sequence.push_back(T(other.forward_sequence[i]));
+            backward_sequence.push_back(T(other.backward_sequence[i]));
+            if (forward_sequence.back() == T(0)) {
+                throw VanishingTerm(i);
+            }
+        }
+    }
+
+    std::vector<BigInt> Lift(long long left, long long right, size_t primes) const; // exact terms by CRT from Zp images
+
+    // Extends the two caches once and copies the range out of them
+    std::vector<T> Materialize(long long lo, long long hi) override {
+        std::vector<T> terms;
+        if (lo >= hi) {
+            return terms;
+        }
+        terms.reserve(hi - lo);
+        if (lo < 0) {
+            (*this)[lo];
+            for (long long n = lo; n < std::min(hi, 0LL); ++n) {
+                terms.push_back(backward_sequence[k - 1 - n]);
+            }
+        }
+        if (hi > 0) {
+            (*this)[hi - 1];
+            terms.insert(terms.end(), forward_sequence.begin() + std::max(lo, 0LL), forward_sequence.begin() + hi);
+        }
+        return terms;
+    }
+
     T operator [] (long long n) override {
         if (n >= 0) {
             int64_t nt = n;
@@ -74,10 +248,10 @@ public:
                     for (size_t j = 1; j <= k / 2; ++j) {
                         next_elem += (coefs[j - 1] * forward_sequence[i - j] * forward_sequence[i - k + j]);
                     }
-                    next_elem = next_elem / forward_sequence[i - k];
+                    Divide(next_elem, forward_sequence[i - k], i);
                     
                     if (next_elem == T(0)) {
-                        throw std::runtime_error("Zero element in sequence");
+                        throw VanishingTerm(i);
                     }
 
                     forward_sequence.push_back(next_elem);
@@ -92,10 +266,10 @@ public:
                     for (int64_t j = 1; j <= k / 2; ++j) {
                         next_elem += (coefs[j - 1] * backward_sequence[i - j] * backward_sequence[i - k + j]);
                     }
-                    next_elem = next_elem / backward_sequence[i - k];
+                    Divide(next_elem, backward_sequence[i - k], k - 1 - i);
                     
                     if (next_elem == T(0)) {
-                        throw std::runtime_error("Zero element in sequence");
+                        throw VanishingTerm(k - 1 - i);
                     }
 
                     backward_sequence.push_back(next_elem);
@@ -106,6 +280,62 @@ public:
     }
 };
 
+/*
+    Exact terms s_{left}, ..., s_{right - 1} of an integral Somos sequence,
+    without computing over the integers: the recurrence is run in Zp<> for
+    random 61-bit primes, skipping every prime modulo which a term vanishes,
+    and the images are combined by Garner's CRT into symmetric residues.
+    The terms are exact as long as 2 |s_n| stays below the product of the
+    primes, that is |s_n| < 2^(60 * primes - 1). T must convert to Zp<>
+    (BigInt or a built-in integer). Changes the modulus of Zp<>.
+    A random prime divides a nonzero term with probability below 2^-55,
+    so a term vanishing for two primes is taken to be 0 over Z (or to have
+    a vanishing denominator) and its VanishingTerm is rethrown, as is the
+    one of any prime failing after 2 * primes + 2 others have failed.
+*/
+template <typename T>
+std::vector<BigInt> SomosSequence<T>::Lift(long long left, long long right, size_t primes) const {
+    static std::mt19937_64 generator(std::random_device{}());
+    const size_t count = right > left ? right - left : 0;
+    std::vector<BigInt> terms(count, BigInt(0));
+    std::vector<uint64_t> images(count);
+    BigInt modulus = 1;
+    std::vector<long long> vanished;
+    for (size_t used = 0; used < primes; ) {
+        const uint64_t prime = random_prime(61, generator);
+        Zp<>::SetModulus(prime);
+        try {
+            SomosSequence<Zp<>> image(*this);
+            for (size_t i = 0; i < count; ++i) {
+                images[i] = image[left + i].Value();
+            }
+        } catch (const VanishingTerm& e) {
+            if (std::find(vanished.begin(), vanished.end(), e.index) != vanished.end() || vanished.size() >= 2 * primes + 2) {
+                throw;
+            }
+            vanished.push_back(e.index);
+            continue;
+        }
+
+        // x += M * ((r - x) / M mod p), so that x stays the residue modulo M * p
+        const uint64_t modulus_inverse = inverse_mod(modulus.residue(prime), prime);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t t = mul_mod(sub_mod(images[i], terms[i].residue(prime), prime), modulus_inverse, prime);
+            terms[i].addmul(modulus, BigInt((long long) t));
+        }
+        modulus *= BigInt((long long) prime);
+        ++used;
+    }
+
+    const BigInt half = modulus / 2;
+    for (BigInt& term : terms) {
+        if (term > half) {
+            term -= modulus;
+        }
+    }
+    return terms;
+}
+
 template <typename T>
 class ShiftedSomosSequence : public Sequence<T> {
     SomosSequence<T>& s;
@@ -118,6 +348,22 @@ public:
     T operator [] (long long n) override {
 	return s[p * n + k];
     }
+
+    // Every p-th term of one materialized range of s
+    std::vector<T> Materialize(long long lo, long long hi) override {
+        std::vector<T> terms;
+        if (lo >= hi) {
+            return terms;
+        }
+        const long long first = std::min(p * lo, p * (hi - 1)) + k;
+        const long long last = std::max(p * lo, p * (hi - 1)) + k;
+        const std::vector<T> base = s.Materialize(first, last + 1);
+        terms.reserve(hi - lo);
+        for (long long n = lo; n < hi; ++n) {
+            terms.push_back(base[p * n + k - first]);
+        }
+        return terms;
+    }
 };
 
 template <typename T>
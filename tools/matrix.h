@@ -1,9 +1,24 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <ostream>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include "numbers/bigint.hpp"
+#include "numbers/modular.h"
+#include "numbers/tropical.h"
+#include "numbers/zp.h"
+#include "row_kernels.h"
 
 BigInt factorial(BigInt n) {
     BigInt res = 1;
@@ -16,165 +31,1584 @@ BigInt factorial(BigInt n) {
 template<typename F>
 class Sequence;
 
+// Whether F is a field. Matrices over other rings (BigInt, built-in integers) are eliminated fraction-free.
+template<typename F>
+struct is_field : std::integral_constant<bool, !std::is_integral<F>::value> {
+};
+
+template<>
+struct is_field<BigInt> : std::false_type {
+};
+
 template<typename F>
 class Matrix;
 
+template<typename F>
+class MatrixView;
+
+template<typename Update>
+void update_rows(size_t begin, size_t end, const Update& update);
+
 template<typename F>
 std::ostream& operator << (std::ostream& os, Matrix<F>& m);
 
+// Non-owning view of a contiguous row, in the manner of std::span. F may be const-qualified
+template<typename F>
+class row_span {
+    F* first;
+    size_t length;
+public:
+    row_span(F* first, size_t length) : first(first), length(length) {
+    }
+
+    // A mutable row is also a read-only one
+    template<typename G, typename = typename std::enable_if<std::is_same<const G, F>::value>::type>
+    row_span(const row_span<G>& other) : first(other.data()), length(other.size()) {
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    F* data() const {
+        return first;
+    }
+
+    F* begin() const {
+        return first;
+    }
+
+    F* end() const {
+        return first + length;
+    }
+
+    F& operator [] (size_t i) const {
+        return first[i];
+    }
+};
+
 /*
     Matrix class definition.
 */
 template<typename F>
 class Matrix {
-    std::vector<std::vector<F>> data;
+    std::vector<F> data; // Row-major, entry (i, j) is data[i * cols + j]
+    size_t rows = 0;
+    size_t cols = 0;
 public:
     Matrix() = default;
     Matrix(const std::vector<std::vector<F>>&); // Basic constructor from vector of vectors
     Matrix(const std::vector<std::vector<F>>&, const std::vector<size_t>&, const std::vector<size_t>&);
     Matrix(const Matrix<F>&, const std::vector<size_t>&, const std::vector<size_t>&); // Takes a matrix and vectors of rows and columns indices and constructs a submatrix with these indices
-    Matrix(Sequence<F>&, int64_t, int64_t matrix_type=0); // Takes a sequence as an argument and constructs M0 if matrix_type=0, M1 if matrix_type=1 and throws exception else
+    Matrix(Sequence<F>&, int64_t, int64_t matrix_type=0); // Takes a sequence as an argument and constructs M0 if matrix_type=0, M1 if matrix_type=1, the Hankel matrix s[m+n] if matrix_type=2, the Toeplitz matrix s[m-n] if matrix_type=3 and throws exception else
+    explicit Matrix(const MatrixView<F>&); // Materializes a view
 
-    F LazyDeterminant() const; // F may be a semiring or semifield. Complexity is O(n * n!)
-    F GaussDeterminant() const; // F requires to be a field. Complexity is O(n^3)
+    size_t Rows() const;
+    size_t Cols() const;
+    row_span<F> operator [] (size_t);
+    row_span<const F> operator [] (size_t) const;
 
-    size_t GaussRank() const; // F requires to be a field. Complexity is O(n^3)
+    F LazyDeterminant() const; // F may be a semiring or semifield. Complexity is O(n!)
+    F GaussDeterminant() const &; // F requires to be a field. Complexity is O(n^3)
+    F GaussDeterminant() &&; // Same, eliminating in place instead of copying the matrix
+    F BareissDeterminant() const; // F requires to be an integral domain with exact division. Complexity is O(n^3)
+    F DivisionFreeDeterminant() const; // F may be any commutative ring, or a semiring as in LazyDeterminant. Complexity is O(n^4)
+
+    size_t GaussRank() const &; // F requires to be a field. Complexity is O(n^3)
+    size_t GaussRank() &&; // Same, eliminating in place instead of copying the matrix
+    size_t BareissRank() const; // F requires to be an integral domain with exact division. Complexity is O(n^3)
+    size_t Rank() const &; // GaussRank if F is a field, BareissRank otherwise
+    size_t Rank() &&;
+    std::vector<size_t> RankProfile() const; // Ranks of all leading n x n submatrices, n = 0..min(rows, cols). F requires to be a field or an integral domain with exact division. Complexity is O(n^2 r) for rank r
+    bool RankAtMost(size_t r, std::vector<std::vector<F>>* kernel = nullptr) const; // Whether rank <= r, stopping at the (r+1)-th independent row. If so, kernel gets a basis of the right kernel certifying it. F requires to be a field or an integral domain with exact division. Complexity is O(n^2 r)
+    size_t ModularRank(size_t primes = 3, bool verify = false, double* error = nullptr) const; // Rank over Q from ranks modulo random 61-bit primes. F requires residues mod p (BigInt, Rational, integers). Complexity is O(n^3) word operations per prime
+
+    F TropicalDeterminant() const; // F requires to be Tropical<T>: the maximum over permutations of the tropical product, by the Hungarian algorithm. Complexity is O(n^3)
+    bool TropicallySingular() const; // F requires to be Tropical<T>: whether the maximum is attained by two permutations or is tropical zero. Complexity is O(n^3)
+    size_t TropicalRank() const; // F requires to be Tropical<T>: the size of the largest tropically non-singular square submatrix. Exponential in the worst case, O(n^3) if the matrix is non-singular
     
     template<typename T>
     friend std::ostream& operator << (std::ostream&, Matrix<T>&);
 };
 
+/*
+    MatrixView class definition. A submatrix given by row and column index
+    maps over a parent matrix, which must outlive the view. Nothing is
+    copied: LazyDeterminant reads the parent directly, and the eliminations
+    gather the entries straight into their working matrix, which is the
+    only copy they make.
+*/
+template<typename F>
+class MatrixView {
+    const Matrix<F>* parent;
+    std::vector<size_t> row_index;
+    std::vector<size_t> col_index;
+public:
+    explicit MatrixView(const Matrix<F>&); // The whole matrix
+    MatrixView(const Matrix<F>&, const std::vector<size_t>&, const std::vector<size_t>&); // Rows and columns with these indices
+    MatrixView(const MatrixView<F>&, const std::vector<size_t>&, const std::vector<size_t>&); // Submatrix of a view, indices are relative to the view
+
+    size_t Rows() const;
+    size_t Cols() const;
+    const F& operator () (size_t, size_t) const;
+
+    F LazyDeterminant() const; // F may be a semiring or semifield. Complexity is O(n!)
+    F GaussDeterminant() const; // F requires to be a field. Complexity is O(n^3)
+    size_t GaussRank() const; // F requires to be a field. Complexity is O(n^3)
+    F TropicalDeterminant() const; // F requires to be Tropical<T>. Complexity is O(n^3)
+    bool TropicallySingular() const; // F requires to be Tropical<T>. Complexity is O(n^3)
+};
+
+template<typename F>
+MatrixView<F>::MatrixView(const Matrix<F>& m) : parent(&m), row_index(m.Rows()), col_index(m.Cols()) {
+    for (size_t i = 0; i < row_index.size(); ++i)
+        row_index[i] = i;
+    for (size_t j = 0; j < col_index.size(); ++j)
+        col_index[j] = j;
+}
+
+template<typename F>
+MatrixView<F>::MatrixView(const Matrix<F>& m, const std::vector<size_t>& rows, const std::vector<size_t>& cols) : parent(&m), row_index(rows), col_index(cols) {
+}
+
+template<typename F>
+MatrixView<F>::MatrixView(const MatrixView<F>& v, const std::vector<size_t>& rows, const std::vector<size_t>& cols) : parent(v.parent), row_index(rows.size()), col_index(cols.size()) {
+    for (size_t i = 0; i < rows.size(); ++i)
+        row_index[i] = v.row_index[rows[i]];
+    for (size_t j = 0; j < cols.size(); ++j)
+        col_index[j] = v.col_index[cols[j]];
+}
+
+template<typename F>
+size_t MatrixView<F>::Rows() const {
+    return row_index.size();
+}
+
 template<typename F>
-Matrix<F>::Matrix(const std::vector<std::vector<F>>& data) : data(data) {
+size_t MatrixView<F>::Cols() const {
+    return col_index.size();
 }
 
 template<typename F>
-Matrix<F>::Matrix(const std::vector<std::vector<F>>& d, const std::vector<size_t>& rows, const std::vector<size_t>& cols) {
-    data = std::vector<std::vector<F>>(rows.size(), std::vector<F>(cols.size()));
+const F& MatrixView<F>::operator () (size_t i, size_t j) const {
+    return (*parent)[row_index[i]][col_index[j]];
+}
+
+template<typename F>
+F MatrixView<F>::GaussDeterminant() const {
+    return Matrix<F>(*this).GaussDeterminant();
+}
+
+template<typename F>
+size_t MatrixView<F>::GaussRank() const {
+    return Matrix<F>(*this).GaussRank();
+}
+
+template<typename F>
+Matrix<F>::Matrix(const std::vector<std::vector<F>>& d) : rows(d.size()), cols(d.empty() ? 0 : d[0].size()) {
+    data.reserve(rows * cols);
+    for (size_t i = 0; i < rows; ++i) {
+        data.insert(data.end(), d[i].begin(), d[i].end());
+    }
+}
+
+template<typename F>
+Matrix<F>::Matrix(const std::vector<std::vector<F>>& d, const std::vector<size_t>& rows, const std::vector<size_t>& cols) : rows(rows.size()), cols(cols.size()) {
+    data.reserve(rows.size() * cols.size());
     for (size_t i = 0; i < rows.size(); ++i) {
         for (size_t j = 0; j < cols.size(); ++j) {
-            data[i][j] = d[rows[i]][cols[j]];
+            data.push_back(d[rows[i]][cols[j]]);
         }
     }
 }
 
 template<typename F> 
-Matrix<F>::Matrix(const Matrix& m, const std::vector<size_t>& rows, const std::vector<size_t>& cols) {
-    data = std::vector<std::vector<F>>(rows.size(), std::vector<F>(cols.size()));
+Matrix<F>::Matrix(const Matrix& m, const std::vector<size_t>& rows, const std::vector<size_t>& cols) : rows(rows.size()), cols(cols.size()) {
+    data.reserve(rows.size() * cols.size());
     for (size_t i = 0; i < rows.size(); ++i) {
         for (size_t j = 0; j < cols.size(); ++j) {
-            data[i][j] = m.data[rows[i]][cols[j]];
+            data.push_back(m.data[rows[i] * m.cols + cols[j]]);
+        }
+    }
+}
+
+
+// Indices [lo, hi) of the terms read by the size x size matrix of the given type, so that no other term is computed
+void sequence_matrix_range(int64_t size, int64_t matrix_type, int64_t& lo, int64_t& hi) {
+    lo = matrix_type == 2 || size == 0 ? 0 : 1 - size;
+    hi = matrix_type == 3 ? size : std::max<int64_t>(2 * size - 1, 0);
+}
+
+// Entry (m, n) of the matrix of the given type built from a sequence, see the constructor below. s points at the term s_0 of a materialized range
+template<typename F>
+F sequence_matrix_entry(const F* s, int64_t m, int64_t n, int64_t matrix_type) {
+    switch (matrix_type) {
+        case 2:
+            return s[m + n];
+        case 3:
+            return s[m - n];
+        default:
+            return s[m + n] * s[m - n];
+    }
+}
+
+/*
+    Looks for a reflection of the terms s_lo, ..., s_{hi - 1}: a sum with
+    s_j = s_{sum - j}, or s_j = -s_{sum - j} (odd set), wherever both terms
+    are in the range, as for Somos sequences with palindromic initial
+    values and for elliptic divisibility sequences. Only centers keeping at
+    least half of the range inside are tried, from the middle outwards, and
+    a wrong one usually fails at its first pair.
+*/
+template<typename F>
+bool find_reflection(const std::vector<F>& terms, int64_t lo, int64_t& sum, bool& odd) {
+    const int64_t count = terms.size();
+    const int64_t middle = 2 * lo + count - 1;
+    for (int64_t shift = 0; 2 * shift <= count; ++shift) {
+        for (int64_t candidate : {middle - shift, middle + shift}) {
+            for (bool negate : {false, true}) {
+                bool reflects = true;
+                for (int64_t j = std::max(lo, candidate - (lo + count - 1)); 2 * j < candidate && reflects; ++j)
+                    reflects = terms[j - lo] == (negate ? -terms[candidate - j - lo] : terms[candidate - j - lo]);
+                if (reflects) {
+                    sum = candidate;
+                    odd = negate;
+                    return true;
+                }
+            }
+            if (shift == 0)
+                break;
         }
     }
+    return false;
 }
 
+// Whether the M0 and M1 constructor shares the products of reflected terms: for big number types, where a multiplication costs more than the sort, with a unary minus for odd reflections
+template<typename F, typename = void>
+struct shares_reflected_products : std::false_type {
+};
 
 template<typename F>
-Matrix<F>::Matrix(Sequence<F>& sequence, int64_t size, int64_t matrix_type) {
-    data = std::vector<std::vector<F>>(size, std::vector<F>(size));
-    if (matrix_type != 0 && matrix_type != 1)
-        throw std::invalid_argument("matrix_type is not 0 or 1");
+struct shares_reflected_products<F, decltype(void(-std::declval<const F&>()))> : std::integral_constant<bool, !std::is_trivially_copyable<F>::value> {
+};
 
+/*
+    Fills the size x size matrix M0 (or M1) of the terms s_lo, ... if they
+    are reflected (see find_reflection), returning false otherwise. The
+    products s_{m+n} s_{m-n} are all distinct as index pairs, but with each
+    term replaced by its reflection nearest the start many coincide: the
+    entries are sorted by their unordered pair of terms and each product is
+    computed once, the distinct products over ELIMINATION_THREADS threads.
+*/
+template<typename F>
+bool fill_reflected_products(std::vector<F>& data, const std::vector<F>& terms, int64_t lo, int64_t size, std::true_type) {
+    int64_t sum;
+    bool odd;
+    if (!find_reflection(terms, lo, sum, odd))
+        return false;
+
+    const F* s = terms.data() - lo;
+    const auto reflect = [&](int64_t j, bool& flip) {
+        const bool reflected = sum - j >= lo && sum - j < j;
+        flip = flip != (reflected && odd);
+        return reflected ? sum - j : j;
+    };
+    const uint64_t width = terms.size();
+    std::vector<std::pair<uint64_t, size_t>> keys(size * size);     // (unordered pair of terms, entry)
+    std::vector<bool> negate(size * size);
     for (int64_t m = 0; m < size; ++m) {
         for (int64_t n = 0; n < size; ++n) {
-            data[m][n] = sequence[m + n] * sequence[m - n];
+            bool flip = false;
+            const int64_t a = reflect(m + n, flip), b = reflect(m - n, flip);
+            keys[m * size + n] = {(uint64_t) (std::min(a, b) - lo) * width + (uint64_t) (std::max(a, b) - lo), m * size + n};
+            negate[m * size + n] = flip;
         }
     }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<size_t> first;     // the start of each run of equal pairs in keys
+    for (size_t i = 0; i < keys.size(); ++i)
+        if (i == 0 || keys[i].first != keys[i - 1].first)
+            first.push_back(i);
+    first.push_back(keys.size());
+    update_rows(0, first.size() - 1, [&](size_t g) {
+        const int64_t a = keys[first[g]].first / width + lo, b = keys[first[g]].first % width + lo;
+        const F product = s[a] * s[b];
+        for (size_t i = first[g]; i < first[g + 1]; ++i)
+            data[keys[i].second] = negate[keys[i].second] ? -product : product;
+    });
+    return true;
+}
+
+template<typename F>
+bool fill_reflected_products(std::vector<F>&, const std::vector<F>&, int64_t, int64_t, std::false_type) {
+    return false;
+}
+
+// The terms are materialized at once, one virtual call instead of 2 n^2, and the entries gathered from the array, in rows over ELIMINATION_THREADS threads
+template<typename F>
+Matrix<F>::Matrix(Sequence<F>& sequence, int64_t size, int64_t matrix_type) : data(size * size), rows(size), cols(size) {
+    if (matrix_type < 0 || matrix_type > 3)
+        throw std::invalid_argument("matrix_type is not 0, 1, 2 or 3");
+
+    int64_t lo, hi;
+    sequence_matrix_range(size, matrix_type, lo, hi);
+    const std::vector<F> terms = sequence.Materialize(lo, hi);
+    if (matrix_type <= 1 && fill_reflected_products(data, terms, lo, size, shares_reflected_products<F>()))
+        return;
+
+    const F* s = terms.data() - lo;
+    update_rows(0, size, [&](size_t m) {
+        F* out = data.data() + m * size;
+        for (int64_t n = 0; n < size; ++n) {
+            out[n] = sequence_matrix_entry(s, m, n, matrix_type);
+        }
+    });
+}
+
+template<typename F>
+Matrix<F>::Matrix(const MatrixView<F>& v) : rows(v.Rows()), cols(v.Cols()) {
+    data.reserve(rows * cols);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            data.push_back(v(i, j));
+        }
+    }
+}
+
+template<typename F>
+size_t Matrix<F>::Rows() const {
+    return rows;
+}
+
+template<typename F>
+size_t Matrix<F>::Cols() const {
+    return cols;
+}
+
+template<typename F>
+row_span<F> Matrix<F>::operator [] (size_t i) {
+    return row_span<F>(data.data() + i * cols, cols);
+}
+
+template<typename F>
+row_span<const F> Matrix<F>::operator [] (size_t i) const {
+    return row_span<const F>(data.data() + i * cols, cols);
 }
 
 
 //Calculates determinant
 template<typename F>
 F Matrix<F>::LazyDeterminant() const {
-    std::vector<size_t> perm(data.size());
-    for (size_t i = 0; i < perm.size(); ++i) {
-        perm[i] = i;
+    return MatrixView<F>(*this).LazyDeterminant();
+}
+
+// Computes acc -= a * b in place when F provides a fused submul (BigInt, Rational)
+template<typename F>
+auto fused_submul(F& acc, const F& a, const F& b, int) -> decltype(acc.submul(a, b), void()) {
+    acc.submul(a, b);
+}
+
+template<typename F>
+void fused_submul(F& acc, const F& a, const F& b, long) {
+    acc -= a * b;
+}
+
+// Computes acc += a * b in place when F provides a fused addmul (BigInt), with only + and * otherwise
+template<typename F>
+auto fused_addmul(F& acc, const F& a, const F& b, int) -> decltype(acc.addmul(a, b), void()) {
+    acc.addmul(a, b);
+}
+
+template<typename F>
+void fused_addmul(F& acc, const F& a, const F& b, long) {
+    acc = acc + a * b;
+}
+
+// Computes num /= den where den is known to divide num, using exact division when F provides it (BigInt)
+template<typename F>
+auto exact_divide(F& num, const F& den, int) -> decltype(num.divexact(den), void()) {
+    num.divexact(den);
+}
+
+template<typename F>
+void exact_divide(F& num, const F& den, long) {
+    num = num / den;
+}
+
+#define row std::vector<F>
+
+// Number of threads updating the rows under each pivot in GaussRank, GaussDeterminant and the Bareiss
+// eliminations, the clow heads in DivisionFreeDeterminant and the first row choices in LazyDeterminant.
+// The rows are independent, so the result does not depend on it. 1 keeps them sequential. The threads
+// are kept in a pool (see row_pool) between calls
+size_t ELIMINATION_THREADS = 1;
+
+/*
+    Persistent workers for update_rows, so that an elimination does not
+    start and join threads at every pivot, and the thread_local scratch
+    buffers of BigInt and Rational survive between pivots. The caller takes
+    part in each run. Indices are handed out in chunks from an atomic
+    counter, several chunks per thread, so that rows of uneven cost (e.g.
+    Rational entries of different sizes) balance out; every index is still
+    computed by exactly one call, so the result does not depend on the
+    schedule. An exception thrown by an update is rethrown to the caller.
+*/
+class row_pool {
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(size_t)>* task = nullptr;
+    std::atomic<size_t> next{0};
+    size_t end = 0;
+    size_t chunk = 1;
+    size_t generation = 0;      // number of runs started, a worker takes part in each once
+    size_t busy = 0;            // workers still in the current run
+    bool stop = false;
+    std::exception_ptr error;
+
+    void Drain() {
+        try {
+            for (size_t j = next.fetch_add(chunk); j < end; j = next.fetch_add(chunk))
+                for (size_t k = j; k < std::min(end, j + chunk); ++k)
+                    (*task)(k);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error)
+                error = std::current_exception();
+            next = end;
+        }
+    }
+
+    void Work() {
+        InPool() = true;
+        size_t seen = 0;
+        for (;;) {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stop || generation != seen; });
+            if (stop)
+                return;
+            seen = generation;
+            lock.unlock();
+            Drain();
+            lock.lock();
+            if (--busy == 0)
+                done.notify_one();
+        }
+    }
+
+public:
+    explicit row_pool(size_t threads) {
+        for (size_t t = 0; t < threads; ++t)
+            workers.emplace_back([this]() { Work(); });
+    }
+
+    ~row_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
     }
 
-    BigInt perm_num = factorial(BigInt((long long)data.size()));
+    // Number of threads running the updates, the caller included
+    size_t Threads() const {
+        return workers.size() + 1;
+    }
+
+    // Whether the current thread is running a pool task, so that a nested update_rows stays sequential
+    static bool& InPool() {
+        static thread_local bool in_pool = false;
+        return in_pool;
+    }
+
+    void Run(size_t begin, size_t end_index, const std::function<void(size_t)>& update) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &update;
+            next = begin;
+            end = end_index;
+            chunk = std::max<size_t>(1, (end_index - begin) / (4 * Threads()));
+            busy = workers.size();
+            error = nullptr;
+            ++generation;
+        }
+        wake.notify_all();
+        InPool() = true;
+        Drain();
+        InPool() = false;
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return busy == 0; });
+        if (error)
+            std::rethrow_exception(error);
+    }
+};
+
+// The pool of ELIMINATION_THREADS threads, rebuilt when the setting changes. Runs hold pool_mutex
+row_pool& elimination_pool() {
+    static std::unique_ptr<row_pool> pool;
+    if (!pool || pool->Threads() != ELIMINATION_THREADS)
+        pool.reset(new row_pool(ELIMINATION_THREADS - 1));
+    return *pool;
+}
+
+std::mutex& elimination_pool_mutex() {
+    static std::mutex pool_mutex;
+    return pool_mutex;
+}
+
+// Calls update(j) for begin <= j < end over the ELIMINATION_THREADS threads of the pool. Runs sequentially when nested in a pool task or while another thread is using the pool
+template<typename Update>
+void update_rows(size_t begin, size_t end, const Update& update) {
+    const size_t count = end > begin ? end - begin : 0;
+    std::unique_lock<std::mutex> lock;
+    if (ELIMINATION_THREADS > 1 && count > 1 && !row_pool::InPool())
+        lock = std::unique_lock<std::mutex>(elimination_pool_mutex(), std::try_to_lock);
+    if (!lock.owns_lock()) {
+        for (size_t j = begin; j < end; ++j)
+            update(j);
+        return;
+    }
+
+    const std::function<void(size_t)> task = std::cref(update);
+    elimination_pool().Run(begin, end, task);
+}
+
+// Adds the products of the permutations extending perm[0..d) to pos or neg by parity, prefix[d] being the product of the rows above
+template<typename F>
+void expand_permutations(const MatrixView<F>& m, size_t d, bool odd, std::vector<size_t>& perm, std::vector<F>& prefix, F& pos, F& neg) {
+    const size_t n = perm.size();
+    if (d + 1 == n) {
+        fused_addmul(odd ? neg : pos, prefix[d], m(d, perm[d]), 0);
+        return;
+    }
+    for (size_t k = d; k < n; ++k) {
+        std::swap(perm[d], perm[k]);
+        prefix[d + 1] = prefix[d] * m(d, perm[d]);
+        expand_permutations(m, d + 1, odd != (k != d), perm, prefix, pos, neg);
+        std::swap(perm[d], perm[k]);
+    }
+}
+
+/*
+    Depth-first expansion along the rows: row d takes each of the columns
+    left in perm[d..n) by a swap into perm[d], every swap of two distinct
+    positions flipping the sign, and extends the product of the rows above
+    by one multiplication, so a permutation costs O(1) amortized instead of
+    O(n) for its product and O(n^2) for its inversions. The choices of the
+    first row are independent subtrees, spread over ELIMINATION_THREADS
+    threads and summed in order.
+*/
+template<typename F>
+F MatrixView<F>::LazyDeterminant() const {
+    const size_t n = Rows();
+    if (n == 0)
+        return F(1);
+    if (n == 1)
+        return (*this)(0, 0);
+
+    std::vector<F> pos(n, F(0)), neg(n, F(0));
+    update_rows(0, n, [&](size_t first) {
+        std::vector<size_t> perm(n);
+        for (size_t i = 0; i < n; ++i)
+            perm[i] = i;
+        std::swap(perm[0], perm[first]);
+        std::vector<F> prefix(n);
+        prefix[1] = (*this)(0, perm[0]);
+        expand_permutations(*this, 1, first != 0, perm, prefix, pos[first], neg[first]);
+    });
+
     F pos_det = F(0);
     F neg_det = F(0);
-    for (BigInt i = BigInt(0); i < perm_num; ++i) {
-        size_t inv_cnt = 0;
-        for (size_t u = 0; u < perm.size(); ++u)
-            for (size_t j = u + 1; j < perm.size(); ++j)
-                if (perm[u] > perm[j])
-                    ++inv_cnt;
+    for (size_t first = 0; first < n; ++first) {
+        pos_det = pos_det + pos[first];
+        neg_det = neg_det + neg[first];
+    }
+    return pos_det - neg_det;
+}
+
+// Row subtraction lhs[i] -= coef * rhs[i] for pos <= i < size
+template<typename F>
+void subtract_row(F* lhs, const F* rhs, const F& coef, const size_t pos, const size_t size) {
+    for (size_t i = pos; i < size; ++i) {
+	fused_submul(lhs[i], coef, rhs[i], 0);
+    }
+}
+
+// Vectorized for double, see row_kernels.h
+void subtract_row(double* lhs, const double* rhs, const double& coef, const size_t pos, const size_t size) {
+    if (pos < size)
+        axpy_double(lhs + pos, rhs + pos, coef, size - pos);
+}
+
+// Through the word kernels for Zp, vectorized with a modulus below 2^32. Multiplying Montgomery forms by the plain value of coef keeps them in Montgomery form
+template<uint64_t P>
+void subtract_row(Zp<P>* lhs, const Zp<P>* rhs, const Zp<P>& coef, const size_t pos, const size_t size) {
+    if (pos < size)
+        axpy_mod(reinterpret_cast<uint64_t*>(lhs + pos), reinterpret_cast<const uint64_t*>(rhs + pos), coef.Value(), Zp<P>::Modulus(), size - pos);
+}
+
+
+/*
+    Mahajan-Vinay. The determinant is the signed sum over clow sequences:
+    closed walks, each starting and ending at its smallest vertex (the
+    head), with increasing heads and n edges in total. Those that are not
+    permutations cancel in pairs, so only +, - and * are used. A partial
+    sequence is summarized by the head h of its last clow, the vertex u it
+    has reached and the parity of its number of clows k, the sign being
+    (-1)^(n + k). Each of the n steps adds one edge, and the heads update
+    independently before the closed clows are passed on to greater heads.
+    The two parities are summed apart and subtracted once at the end, as
+    in LazyDeterminant, so semirings with a formal difference work too.
+*/
+template<typename F>
+F Matrix<F>::DivisionFreeDeterminant() const {
+    const size_t n = rows;
+    if (n == 0)
+        return F(1);
+
+    // walks[p][h * n + u] sums the partial sequences with k = p mod 2 whose last clow has head h and is at u
+    std::vector<F> walks[2] = {std::vector<F>(n * n, F(0)), std::vector<F>(n * n, F(0))};
+    std::vector<F> next[2] = {walks[0], walks[1]};
+    std::vector<F> closed[2] = {std::vector<F>(n, F(0)), std::vector<F>(n, F(0))};
+    for (size_t h = 0; h < n; ++h)
+        walks[1][h * n + h] = F(1);
+
+    const auto step = [&](size_t h) {
+        for (size_t p = 0; p < 2; ++p) {
+            F* out = next[p].data() + h * n;
+            std::fill(out + h, out + n, F(0));
+            F close = F(0);
+            for (size_t u = h; u < n; ++u) {
+                const F& w = walks[p][h * n + u];
+                const F* a = data.data() + u * n;
+                for (size_t v = h + 1; v < n; ++v)
+                    fused_addmul(out[v], w, a[v], 0);
+                fused_addmul(close, w, a[h], 0);
+            }
+            closed[p][h] = close;
+        }
+    };
+    for (size_t length = 1; length < n; ++length) {
+        update_rows(0, n, step);
+        // a clow closed at head h is followed by a new clow at any head h' > h
+        for (size_t p = 0; p < 2; ++p) {
+            F sum = F(0);
+            for (size_t h = 0; h < n; ++h) {
+                next[1 - p][h * n + h] = sum;
+                sum = sum + closed[p][h];
+            }
+        }
+        std::swap(walks[0], next[0]);
+        std::swap(walks[1], next[1]);
+    }
+
+    // the last clow closes with the n-th edge
+    update_rows(0, n, step);
+    F total[2] = {F(0), F(0)};
+    for (size_t p = 0; p < 2; ++p)
+        for (size_t h = 0; h < n; ++h)
+            total[p] = total[p] + closed[p][h];
+    return total[n % 2] - total[1 - n % 2];
+}
+
+template<typename F>
+size_t Matrix<F>::GaussRank() const & {
+    return Matrix<F>(*this).GaussRank();
+}
+
+// Rows are exchanged through the permutation perm instead of being moved, row perm[i] standing in the i-th place
+template<typename F>
+size_t Matrix<F>::GaussRank() && {
+    size_t rank = 0;
+    if (word_field_rank(*this, rank, 0))
+        return rank;
+
+    std::vector<size_t> perm(rows);
+    for (size_t i = 0; i < rows; ++i)
+        perm[i] = i;
+
+    for (size_t i = 0; i < cols && rank < rows; ++i) {
+        size_t pivot = rank;
+        while (pivot < rows && !((*this)[perm[pivot]][i] != 0))
+            ++pivot;
+        if (pivot == rows)
+            continue;
+        std::swap(perm[rank], perm[pivot]);
+
+        const row_span<const F> pivot_row = (*this)[perm[rank]];
+        update_rows(rank + 1, rows, [&](size_t j) {
+            row_span<F> r = (*this)[perm[j]];
+            if (r[i] != 0) {
+                const F coef = r[i] / pivot_row[i];
+                subtract_row(r.data(), pivot_row.data(), coef, i, cols);
+            }
+        });
+        ++rank;
+    }
+    return rank;
+}
+
+template<typename F>
+F Matrix<F>::GaussDeterminant() const & {
+    return Matrix<F>(*this).GaussDeterminant();
+}
 
-        F mul = F(1);
-        for (size_t u = 0; u < data.size(); ++u) {
-            mul = mul * data[u][perm[u]];
+// The product of the pivots, negated for every row exchange
+template<typename F>
+F Matrix<F>::GaussDeterminant() && {
+    std::vector<size_t> perm(rows);
+    for (size_t i = 0; i < rows; ++i)
+        perm[i] = i;
+
+    F det = F(1);
+    for (size_t i = 0; i < rows; ++i) {
+        size_t pivot = i;
+        while (pivot < rows && !((*this)[perm[pivot]][i] != 0))
+            ++pivot;
+        if (pivot == rows)
+            return F(0);
+        if (pivot != i) {
+            std::swap(perm[i], perm[pivot]);
+            det = -det;
         }
 
-        if (inv_cnt % 2 == 0)
-            pos_det = pos_det + mul;
-        else
-            neg_det = neg_det + mul;
-        std::next_permutation(perm.begin(), perm.end());
+        const row_span<const F> pivot_row = (*this)[perm[i]];
+        det *= pivot_row[i];
+        update_rows(i + 1, rows, [&](size_t j) {
+            row_span<F> r = (*this)[perm[j]];
+            if (r[i] != 0) {
+                const F coef = r[i] / pivot_row[i];
+                subtract_row(r.data(), pivot_row.data(), coef, i + 1, cols);
+            }
+        });
     }
-    return pos_det - neg_det;
+    return det;
 }
 
-#define row std::vector<F>
+/*
+    Bareiss fraction-free elimination. After the pivot of step k, every entry
+    below it is a (k+1)x(k+1) minor of the original matrix, so the update
+    (pivot * a - b * c) / previous_pivot divides exactly and the entries grow
+    only linearly in size, without any gcd. This holds for pivots in any
+    columns, so a column without a pivot is simply skipped.
+*/
+template<typename F>
+size_t Matrix<F>::BareissRank() const {
+    Matrix<F> work(*this);
+    std::vector<size_t> perm(rows);
+    for (size_t i = 0; i < rows; ++i)
+        perm[i] = i;
+
+    F prev_pivot = F(1);
+    size_t rank = 0;
+    for (size_t i = 0; i < cols && rank < rows; ++i) {
+        size_t pivot = rank;
+        while (pivot < rows && !(work[perm[pivot]][i] != 0))
+            ++pivot;
+        if (pivot == rows)
+            continue;
+        std::swap(perm[rank], perm[pivot]);
 
-// Function for vector subtraction
+        const row_span<const F> pivot_row = work[perm[rank]];
+        update_rows(rank + 1, rows, [&](size_t j) {
+            row_span<F> r = work[perm[j]];
+            for (size_t k = i + 1; k < cols; ++k) {
+                r[k] *= pivot_row[i];
+                fused_submul(r[k], r[i], pivot_row[k], 0);
+                exact_divide(r[k], prev_pivot, 0);
+            }
+            r[i] = F(0);
+        });
+        prev_pivot = pivot_row[i];
+        ++rank;
+    }
+    return rank;
+}
+
+// The last Bareiss pivot is the determinant itself, up to the sign of the row swaps
 template<typename F>
-row& subtract_row(row& lhs, const row& rhs, const F& coef, const size_t pos = 0) {
-    if (lhs.size() != rhs.size())
-        throw;
-    //throw std::exception("Subtracting rows of different sizes");
+F Matrix<F>::BareissDeterminant() const {
+    Matrix<F> work(*this);
+    std::vector<size_t> perm(rows);
+    for (size_t i = 0; i < rows; ++i)
+        perm[i] = i;
+
+    F prev_pivot = F(1);
+    bool negate = false;
+    for (size_t i = 0; i < rows; ++i) {
+        size_t pivot = i;
+        while (pivot < rows && !(work[perm[pivot]][i] != 0))
+            ++pivot;
+        if (pivot == rows)
+            return F(0);
+        if (pivot != i) {
+            std::swap(perm[i], perm[pivot]);
+            negate = !negate;
+        }
 
-    for (size_t i = pos; i < lhs.size(); ++i) {
-	lhs[i] -= coef * rhs[i];
+        const row_span<const F> pivot_row = work[perm[i]];
+        update_rows(i + 1, rows, [&](size_t j) {
+            row_span<F> r = work[perm[j]];
+            for (size_t k = i + 1; k < rows; ++k) {
+                r[k] *= pivot_row[i];
+                fused_submul(r[k], r[i], pivot_row[k], 0);
+                exact_divide(r[k], prev_pivot, 0);
+            }
+        });
+        prev_pivot = pivot_row[i];
     }
-    return lhs;
+    return negate ? -prev_pivot : prev_pivot;
 }
 
-// Fuction for comparing a vector with zero vector
 template<typename F>
-bool non_zero_row(const row& r) {
-    for (size_t i = 0; i < r.size(); ++i)
-        if (r[i] != 0)
-	    return true;
+size_t Matrix<F>::Rank() const & {
+    if (is_field<F>::value)
+        return GaussRank();
+    return BareissRank();
+}
+
+template<typename F>
+size_t Matrix<F>::Rank() && {
+    if (is_field<F>::value)
+        return std::move(*this).GaussRank();
+    return BareissRank();
+}
+
+/*
+    Rank profile of the leading submatrices in one pass. The rows are
+    inserted one by one into a basis in row echelon form, each basis row
+    having its leftmost non-zero entry, equal to 1, in its own pivot column.
+    Over integral domains the basis is fraction-free (insert_bareiss_row),
+    with the same pivot columns: dividing by the pivots, as the field
+    version does, would truncate. The projection of the span of the first
+    n rows onto the first n columns is spanned by the basis rows with pivot
+    column < n, the others vanish there, so the leading n x n submatrix has
+    rank equal to the number of pivots (row i, column c) with max(i, c) < n.
+*/
+// Reduces r against an echelon basis with unit pivots, kept ordered by pivot column, and inserts the remainder if it is non-zero. Returns the pivot column of the inserted row, or r.size() if r was dependent
+template<typename F>
+size_t insert_echelon_row(std::vector<row>& basis, std::vector<size_t>& pivots, row r) {
+    for (size_t t = 0; t < basis.size(); ++t) {
+        if (r[pivots[t]] != 0) {
+            const F coef = r[pivots[t]];
+            subtract_row(r.data(), basis[t].data(), coef, pivots[t], r.size());
+        }
+    }
+
+    size_t c = 0;
+    while (c < r.size() && !(r[c] != 0))
+        ++c;
+    if (c == r.size())
+        return c;
+    const F inverse = F(1) / r[c];
+    for (size_t k = c; k < r.size(); ++k)
+        r[k] *= inverse;
+
+    const size_t position = std::lower_bound(pivots.begin(), pivots.end(), c) - pivots.begin();
+    pivots.insert(pivots.begin() + position, c);
+    basis.insert(basis.begin() + position, std::move(r));
+    return c;
+}
+
+/*
+    Fraction-free counterpart of insert_echelon_row: basis[t] is the pivot
+    row of the t-th Bareiss step, with pivot basis[t][pivots[t]], and r
+    goes through the same steps r = (pivot * r - r[pivot column] * basis[t])
+    / previous pivot, each division exact. The entries of r are then minors
+    of the matrix, so they stay small, and r vanishes iff it lies in the
+    span of the basis. Otherwise it is appended. Each basis row vanishes
+    on the pivot columns of the rows before it, as the echelon basis
+    does, but the rows are kept in insertion order. Returns the pivot
+    column of the inserted row, or r.size() if r was dependent. F requires
+    to be an integral domain with exact division. Complexity is
+    O(basis.size() * n)
+*/
+template<typename F>
+size_t insert_bareiss_row(std::vector<row>& basis, std::vector<size_t>& pivots, row r) {
+    F prev_pivot = F(1);
+    for (size_t t = 0; t < basis.size(); ++t) {
+        const F& pivot = basis[t][pivots[t]];
+        const F coef = r[pivots[t]];
+        for (size_t k = 0; k < r.size(); ++k) {
+            r[k] *= pivot;
+            fused_submul(r[k], coef, basis[t][k], 0);
+            exact_divide(r[k], prev_pivot, 0);
+        }
+        prev_pivot = pivot;
+    }
+
+    size_t c = 0;
+    while (c < r.size() && !(r[c] != 0))
+        ++c;
+    if (c == r.size())
+        return c;
+    pivots.push_back(c);
+    basis.push_back(std::move(r));
+    return c;
+}
+
+// Inserts r into an echelon basis with unit pivots if F is a field, fraction-free otherwise. Returns the pivot column as both do
+template<typename F>
+size_t insert_basis_row(std::vector<row>& basis, std::vector<size_t>& pivots, row r) {
+    if (is_field<F>::value)
+        return insert_echelon_row(basis, pivots, std::move(r));
+    return insert_bareiss_row(basis, pivots, std::move(r));
+}
+
+/*
+    Berlekamp-Massey. Returns the linear complexity of a, the length of the
+    shortest linear recurrence generating it, maintaining the connection
+    polynomial c and the one b before the last length change. F requires
+    to be a field. Complexity is O(N^2)
+*/
+template<typename F>
+size_t linear_complexity(const std::vector<F>& a) {
+    std::vector<F> c(1, F(1));
+    std::vector<F> b(1, F(1));
+    F last_discrepancy = F(1);
+    size_t length = 0;
+    size_t shift = 1;
+    for (size_t n = 0; n < a.size(); ++n) {
+        F discrepancy = a[n];
+        for (size_t i = 1; i <= length; ++i)
+            discrepancy += c[i] * a[n - i];
+        if (!(discrepancy != 0)) {
+            ++shift;
+            continue;
+        }
+
+        const F coef = discrepancy / last_discrepancy;
+        const bool grows = 2 * length <= n;
+        std::vector<F> previous = grows ? c : std::vector<F>();
+        if (c.size() < b.size() + shift)
+            c.resize(b.size() + shift, F(0));
+        for (size_t i = 0; i < b.size(); ++i)
+            fused_submul(c[i + shift], coef, b[i], 0);
+        if (grows) {
+            length = n + 1 - length;
+            b = std::move(previous);
+            last_discrepancy = discrepancy;
+            shift = 1;
+        } else {
+            ++shift;
+        }
+        if (c.size() < length + 1)
+            c.resize(length + 1, F(0));
+    }
+    return length;
+}
+
+// Rank of the n x n Hankel matrix (a[i + j]) given its 2n - 1 entries. For the linear complexity L of a it equals min(L, 2n - L). Complexity is O(n^2)
+template<typename F>
+size_t hankel_rank(const std::vector<F>& a) {
+    const size_t n = (a.size() + 1) / 2;
+    const size_t length = linear_complexity(a);
+    return std::min(length, 2 * n - length);
+}
+
+template<typename F>
+std::vector<size_t> Matrix<F>::RankProfile() const {
+    const size_t size = std::min(rows, cols);
+    std::vector<row> basis;
+    std::vector<size_t> pivots;
+    std::vector<size_t> ranks(size + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        const row_span<const F> r = (*this)[i];
+        const size_t c = insert_basis_row(basis, pivots, row(r.begin(), r.begin() + size));
+        if (c != size)
+            ++ranks[std::max(i, c) + 1];
+    }
+
+    for (size_t n = 1; n <= size; ++n)
+        ranks[n] += ranks[n - 1];
+    return ranks;
+}
+
+/*
+    Kernel of a fraction-free basis built by insert_bareiss_row, one vector
+    per non-pivot column j. On the pivot columns the basis is triangular in
+    insertion order, and its last pivot d is, up to sign, the minor of the
+    original rows on those columns. By Cramer's rule the kernel vector with
+    d at column j has entries in F, so back substitution from the last row
+    divides exactly. Complexity is O(n r^2) for n columns and rank r
+*/
+template<typename F>
+void bareiss_kernel(const std::vector<row>& basis, const std::vector<size_t>& pivots, size_t cols, std::vector<row>& kernel) {
+    const F last_pivot = basis.empty() ? F(1) : basis.back()[pivots.back()];
+    std::vector<bool> is_pivot(cols, false);
+    for (size_t c : pivots)
+        is_pivot[c] = true;
+
+    kernel.clear();
+    for (size_t j = 0; j < cols; ++j) {
+        if (is_pivot[j])
+            continue;
+        row x(cols, F(0));
+        x[j] = last_pivot;
+        for (size_t t = basis.size(); t-- > 0; ) {
+            F sum = basis[t][j] * last_pivot;
+            for (size_t u = t + 1; u < basis.size(); ++u)
+                fused_addmul(sum, basis[t][pivots[u]], x[pivots[u]], 0);
+            x[pivots[t]] = -sum;
+            exact_divide(x[pivots[t]], basis[t][pivots[t]], 0);
+        }
+        kernel.push_back(std::move(x));
+    }
+}
+
+/*
+    RankAtMost for built-in integers, whose fraction-free minors overflow a
+    word long before the entries do. The elimination runs over BigInt, and
+    each kernel vector is divided by the gcd of its entries before it is
+    converted back, which keeps it as small as a kernel vector can be.
+*/
+template<typename F>
+bool wide_rank_at_most(const Matrix<F>& m, size_t r, std::vector<row>* kernel, std::true_type) {
+    std::vector<std::vector<BigInt>> entries(m.Rows());
+    for (size_t i = 0; i < m.Rows(); ++i)
+        for (const F& x : m[i])
+            entries[i].push_back(BigInt((long long) x));
+    std::vector<std::vector<BigInt>> wide_kernel;
+    if (!Matrix<BigInt>(entries).RankAtMost(r, kernel == nullptr ? nullptr : &wide_kernel))
+        return false;
+    if (kernel == nullptr)
+        return true;
+
+    kernel->clear();
+    for (std::vector<BigInt>& x : wide_kernel) {
+        BigInt content = BigInt(0);
+        for (const BigInt& entry : x)
+            content = gcd(content, entry);
+        kernel->emplace_back();
+        for (BigInt& entry : x)
+            kernel->back().push_back(F(entry.divexact(content).to_long_long()));
+    }
+    return true;
+}
+
+template<typename F>
+bool wide_rank_at_most(const Matrix<F>&, size_t, std::vector<row>*, std::false_type) {
     return false;
 }
 
+/*
+    Decides rank <= r with the row insertion of RankProfile, which stops as
+    soon as r + 1 rows are independent. Otherwise the basis has at most r
+    rows, each inserted row costs O(r n), and back substitution brings the
+    basis to reduced echelon form. Every non-pivot column j then gives the
+    kernel vector with 1 at j and -basis[t][j] at pivot column t; these
+    cols - rank vectors are independent, so A x = 0 for all of them, which
+    takes O(n^2 r) to check, certifies rank <= r. Over integral domains the
+    basis is fraction-free and the kernel comes from bareiss_kernel.
+*/
+template<typename F>
+bool Matrix<F>::RankAtMost(size_t r, std::vector<row>* kernel) const {
+    if (std::is_integral<F>::value)
+        return wide_rank_at_most(*this, r, kernel, std::is_integral<F>());
+
+    std::vector<row> basis;
+    std::vector<size_t> pivots;
+    for (size_t i = 0; i < rows; ++i) {
+        const row_span<const F> x = (*this)[i];
+        insert_basis_row(basis, pivots, row(x.begin(), x.end()));
+        if (basis.size() > r)
+            return false;
+    }
+    if (kernel == nullptr)
+        return true;
+    if (!is_field<F>::value) {
+        bareiss_kernel(basis, pivots, cols, *kernel);
+        return true;
+    }
+
+    for (size_t t = basis.size(); t-- > 0; ) {
+        for (size_t u = 0; u < t; ++u) {
+            if (basis[u][pivots[t]] != 0) {
+                const F coef = basis[u][pivots[t]];
+                subtract_row(basis[u].data(), basis[t].data(), coef, pivots[t], cols);
+            }
+        }
+    }
 
+    kernel->clear();
+    size_t t = 0;
+    for (size_t j = 0; j < cols; ++j) {
+        if (t < pivots.size() && pivots[t] == j) {
+            ++t;
+            continue;
+        }
+        row x(cols, F(0));
+        x[j] = F(1);
+        for (size_t u = 0; u < basis.size(); ++u)
+            x[pivots[u]] = -basis[u][j];
+        kernel->push_back(std::move(x));
+    }
+    return true;
+}
+
+// Reduces an entry modulo a word-size prime. Returns false if the entry has no residue, i.e. the prime divides its denominator
 template<typename F>
-size_t Matrix<F>::GaussRank() const {
-    size_t matrix_size = data.size();
-    std::vector<row> data_cpy = data;
-    size_t search_from = 0;
-    for (size_t i = 0; i < matrix_size; ++i) {
-        for (size_t j = search_from; j < matrix_size; ++j) {
-	    if (data_cpy[j][i] != 0) {
-	        std::swap(data_cpy[search_from], data_cpy[j]);
-		break;
-	    }
-	}
+auto reduce_entry(const F& x, uint64_t prime, uint64_t& result, int) -> decltype(x.residue(prime), bool()) {
+    result = x.residue(prime);
+    return true;
+}
 
-	if (data_cpy[search_from][i] != 0) {
-	    for (size_t j = search_from + 1; j < matrix_size; ++j) {
-	        const F coef = data_cpy[j][i] / data_cpy[search_from][i];
-		subtract_row(data_cpy[j], data_cpy[search_from], coef, i);
-	    }
-	    ++search_from;
-	}
+template<typename F>
+auto reduce_entry(const F& x, uint64_t prime, uint64_t& result, int) -> decltype(x.Numerator().residue(prime), bool()) {
+    uint64_t denominator = x.Denominator().residue(prime);
+    if (denominator == 0)
+        return false;
+    result = mul_mod(x.Numerator().residue(prime), inverse_mod(denominator, prime), prime);
+    return true;
+}
+
+template<typename F>
+typename std::enable_if<std::is_integral<F>::value, bool>::type reduce_entry(const F& x, uint64_t prime, uint64_t& result, int) {
+    long long r = (long long) x % (long long) prime;
+    result = r < 0 ? r + prime : r;
+    return true;
+}
+
+// Upper bound on log2 of the height of an entry, the bits of its numerator plus those of its denominator
+template<typename F>
+auto entry_bits(const F& x, int) -> decltype(x.bit_length(), size_t()) {
+    return x.bit_length();
+}
+
+template<typename F>
+auto entry_bits(const F& x, int) -> decltype(x.Numerator().bit_length(), size_t()) {
+    return x.Numerator().bit_length() + x.Denominator().bit_length();
+}
+
+template<typename F>
+size_t entry_bits(const F&, long) {
+    return 64;
+}
+
+// Word-size elimination blocking: pivots are searched in panels of MODULAR_PANEL columns, and the trailing update is done in tiles of MODULAR_TILE columns
+size_t MODULAR_PANEL = 32;
+size_t MODULAR_TILE = 256;
+
+/*
+    Rank of a rows x cols row-major matrix of residues modulo a prime below
+    2^63, by blocked right-looking elimination. Within a panel of columns
+    the pivots are found and the rows below are updated on the panel only,
+    the multipliers being kept in place of the eliminated entries. The pivot
+    rows are then brought up to date right of the panel, and every row below
+    is updated there at once, A22 -= L21 * U12, a product whose inner sums
+    are accumulated in 128 bits and reduced once per entry instead of once
+    per term. Row updates go through the kernels of row_kernels.h, and below
+    2^32 so does A22, one row of U12 at a time: the vector kernel beats the
+    scalar 128-bit accumulation there by about 3x, while for 61-bit primes,
+    whose kernel is scalar, the two are even. The original indices of the
+    pivot rows are stored in pivot_rows.
+*/
+size_t modular_rank(uint64_t* m, size_t rows, size_t cols, uint64_t prime, std::vector<size_t>& pivot_rows) {
+    std::vector<size_t> index(rows);
+    for (size_t i = 0; i < rows; ++i)
+        index[i] = i;
+
+    // number of products (p - 1)^2 that fit in a 128-bit accumulator
+    const unsigned __int128 square = (unsigned __int128) (prime - 1) * (prime - 1);
+    const size_t max_terms = square == 0 ? SIZE_MAX : (size_t) std::min<unsigned __int128>(~(unsigned __int128) 0 / square, SIZE_MAX);
+    std::vector<unsigned __int128> accumulator(MODULAR_TILE);
+    std::vector<size_t> panel_pivots;
+
+    pivot_rows.clear();
+    size_t rank = 0;
+    for (size_t panel = 0; panel < cols && rank < rows; panel += MODULAR_PANEL) {
+        const size_t panel_end = std::min(cols, panel + MODULAR_PANEL);
+        const size_t first = rank;
+        panel_pivots.clear();
+        for (size_t i = panel; i < panel_end && rank < rows; ++i) {
+            size_t pivot = rank;
+            while (pivot < rows && m[pivot * cols + i] == 0)
+                ++pivot;
+            if (pivot == rows)
+                continue;
+            if (pivot != rank) {
+                std::swap_ranges(m + pivot * cols, m + (pivot + 1) * cols, m + rank * cols);
+                std::swap(index[rank], index[pivot]);
+            }
+
+            const uint64_t* pivot_row = m + rank * cols;
+            const uint64_t inverse = inverse_mod(pivot_row[i], prime);
+            for (size_t j = rank + 1; j < rows; ++j) {
+                uint64_t* r = m + j * cols;
+                if (r[i] == 0)
+                    continue;
+                r[i] = mul_mod(r[i], inverse, prime);
+                axpy_mod(r + i + 1, pivot_row + i + 1, r[i], prime, panel_end - i - 1);
+            }
+            panel_pivots.push_back(i);
+            pivot_rows.push_back(index[rank]);
+            ++rank;
+        }
+        if (panel_end == cols)
+            break;
+
+        // U12: pivot row t right of the panel, less the earlier pivot rows of the panel
+        for (size_t t = 1; t < panel_pivots.size(); ++t) {
+            uint64_t* r = m + (first + t) * cols;
+            for (size_t s = 0; s < t; ++s) {
+                const uint64_t coef = r[panel_pivots[s]];
+                if (coef == 0)
+                    continue;
+                const uint64_t* u = m + (first + s) * cols;
+                axpy_mod(r + panel_end, u + panel_end, coef, prime, cols - panel_end);
+            }
+        }
+
+        // A22 -= L21 * U12, tile by tile
+        for (size_t j = rank; j < rows; ++j) {
+            uint64_t* r = m + j * cols;
+            if (prime >> 32 == 0) {
+                for (size_t s = 0; s < panel_pivots.size(); ++s) {
+                    const uint64_t coef = r[panel_pivots[s]];
+                    if (coef != 0)
+                        axpy_mod32(r + panel_end, m + (first + s) * cols + panel_end, coef, prime, cols - panel_end);
+                }
+                continue;
+            }
+            for (size_t tile = panel_end; tile < cols; tile += MODULAR_TILE) {
+                const size_t tile_end = std::min(cols, tile + MODULAR_TILE);
+                std::fill(accumulator.begin(), accumulator.begin() + (tile_end - tile), 0);
+                size_t terms = 0;
+                for (size_t s = 0; s < panel_pivots.size(); ++s) {
+                    const uint64_t coef = r[panel_pivots[s]];
+                    if (coef == 0)
+                        continue;
+                    if (terms == max_terms) {
+                        for (size_t k = tile; k < tile_end; ++k)
+                            accumulator[k - tile] %= prime;
+                        terms = 1;
+                    }
+                    const uint64_t* u = m + (first + s) * cols;
+                    for (size_t k = tile; k < tile_end; ++k)
+                        accumulator[k - tile] += (unsigned __int128) coef * u[k];
+                    ++terms;
+                }
+                if (terms == 0)
+                    continue;
+                for (size_t k = tile; k < tile_end; ++k)
+                    r[k] = sub_mod(r[k], (uint64_t) (accumulator[k - tile] % prime), prime);
+            }
+        }
     }
+    return rank;
+}
+
+// Rank through the blocked word kernel when F is a prime field with a word-size modulus (Zp), entries being taken out of Montgomery form. Returns false for other F
+template<typename F>
+auto word_field_rank(const Matrix<F>& m, size_t& rank, int) -> decltype(F::Modulus(), m[0][0].Value(), bool()) {
+    std::vector<uint64_t> residues;
+    residues.reserve(m.Rows() * m.Cols());
+    for (size_t i = 0; i < m.Rows(); ++i)
+        for (const F& x : m[i])
+            residues.push_back(x.Value());
+    std::vector<size_t> pivot_rows;
+    rank = modular_rank(residues.data(), m.Rows(), m.Cols(), F::Modulus(), pivot_rows);
+    return true;
+}
 
+template<typename F>
+bool word_field_rank(const Matrix<F>&, size_t&, long) {
+    return false;
+}
+
+/*
+    Multi-modular rank. The rank modulo p never exceeds the rank over Q, and
+    is smaller only if p divides every maximal non-zero minor. Such a minor
+    is bounded by Hadamard's inequality applied to the rows cleared of
+    denominators, so at most log2(H) / 60 of the roughly 2^60 / 42 primes of
+    61 bits divide it. The maximum over independent random primes is then
+    wrong with probability at most (log2(H) / 60 / (2^60 / 42))^primes, which
+    is stored in *error.
+    With verify set the result is proven. The modular rank is already a
+    lower bound, so only the upper bound needs a certificate: the kernel of
+    the pivot rows of the best prime, from RankAtMost over F if it is a
+    field and over BigInt otherwise, has dimension cols - rank, and if every
+    other row is orthogonal to it, checked exactly with one product per row
+    and kernel vector, the rank is at most `rank`. This costs O(rank^2 cols)
+    for the kernel and O(rows * cols * (cols - rank)) for the products. If a
+    product does not vanish the exact Rank() is returned. *error is then zero.
+*/
+template<typename F>
+size_t Matrix<F>::ModularRank(size_t primes, bool verify, double* error) const {
+    static std::mt19937_64 generator(std::random_device{}());
+
+    double height_bits = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        size_t row_bits = 0;
+        for (size_t j = 0; j < cols; ++j)
+            row_bits += entry_bits(data[i * cols + j], 0);
+        height_bits += row_bits + 0.5 * std::log2((double) std::max<size_t>(cols, 1));
+    }
+
+    std::vector<uint64_t> residues(rows * cols);
+    std::vector<size_t> pivot_rows, best_pivot_rows;
     size_t rank = 0;
-    for (size_t i = 0; i < matrix_size; ++i) {
-        if (non_zero_row(data_cpy[i])) {
-	    ++rank;
-	}
+    for (size_t used = 0; used < primes; ) {
+        const uint64_t prime = random_prime(61, generator);
+        bool reduced = true;
+        for (size_t i = 0; i < rows && reduced; ++i)
+            for (size_t j = 0; j < cols && reduced; ++j)
+                reduced = reduce_entry(data[i * cols + j], prime, residues[i * cols + j], 0);
+        if (!reduced)
+            continue;   // the prime divides a denominator, draw another one
+
+        const size_t prime_rank = modular_rank(residues.data(), rows, cols, prime, pivot_rows);
+        if (used == 0 || prime_rank > rank) {
+            rank = prime_rank;
+            best_pivot_rows = pivot_rows;
+        }
+        ++used;
+    }
+
+    if (error != nullptr) {
+        const double bad_fraction = std::min(1.0, height_bits / 60 / (std::ldexp(1.0, 60) / 42));
+        *error = std::pow(bad_fraction, (double) primes);
+    }
+    if (!verify)
+        return rank;
+
+    if (error != nullptr)
+        *error = 0;
+    using exact = typename std::conditional<is_field<F>::value, F, BigInt>::type;
+    std::vector<std::vector<exact>> pivot_entries;
+    for (size_t i : best_pivot_rows)
+        pivot_entries.emplace_back(data.begin() + i * cols, data.begin() + (i + 1) * cols);
+    std::vector<std::vector<exact>> kernel;
+    if (pivot_entries.empty()) {
+        // no pivot rows: the kernel is the whole space, spanned by the unit vectors
+        for (size_t j = 0; j < cols; ++j) {
+            kernel.emplace_back(cols, exact(0));
+            kernel.back()[j] = exact(1);
+        }
+    } else {
+        Matrix<exact>(pivot_entries).RankAtMost(rank, &kernel);
+    }
+
+    std::vector<bool> is_pivot(rows, false);
+    for (size_t i : best_pivot_rows)
+        is_pivot[i] = true;
+    for (size_t i = 0; i < rows; ++i) {
+        if (is_pivot[i])
+            continue;
+        for (const std::vector<exact>& x : kernel) {
+            exact product = exact(0);
+            for (size_t j = 0; j < cols; ++j)
+                fused_addmul(product, exact(data[i * cols + j]), x[j], 0);
+            if (product != 0) {
+                std::vector<std::vector<exact>> entries;
+                for (size_t k = 0; k < rows; ++k)
+                    entries.emplace_back(data.begin() + k * cols, data.begin() + (k + 1) * cols);
+                return Matrix<exact>(entries).Rank();
+            }
+        }
+    }
+    return rank;
+}
+
+template<typename F>
+struct tropical_value;
+
+template<typename T>
+struct tropical_value<Tropical<T>> {
+    using type = T;
+};
+
+/*
+    Hungarian algorithm for a maximum weight permutation of a square matrix
+    over Tropical<T>, i.e. a minimum cost assignment with costs -a(i, j) and
+    tropical zeros as forbidden pairs. Rows are added one at a time along a
+    shortest augmenting path, keeping dual potentials with
+    u[i] + v[j] <= -a(i, j) on every pair, with equality on the assignment.
+    Returns false if every permutation meets a tropical zero; otherwise
+    match[i] is the column of row i and u, v (1-based) are optimal duals.
+    Complexity is O(n^3)
+*/
+template<typename T>
+bool max_weight_assignment(const MatrixView<Tropical<T>>& a, std::vector<size_t>& match, std::vector<T>& u, std::vector<T>& v) {
+    const size_t n = a.Rows();
+    u.assign(n + 1, T(0));
+    v.assign(n + 1, T(0));
+    std::vector<size_t> owner(n + 1, 0), way(n + 1, 0);   // owner[j] is the row assigned to column j, column 0 is the root
+    std::vector<T> min_slack(n + 1);
+    std::vector<bool> reached(n + 1), used(n + 1);
+    for (size_t i = 1; i <= n; ++i) {
+        owner[0] = i;
+        size_t j0 = 0;
+        std::fill(reached.begin(), reached.end(), false);
+        std::fill(used.begin(), used.end(), false);
+        do {
+            used[j0] = true;
+            const size_t i0 = owner[j0];
+            size_t j1 = 0;
+            for (size_t j = 1; j <= n; ++j) {
+                if (used[j])
+                    continue;
+                const Tropical<T>& entry = a(i0 - 1, j - 1);
+                if (!entry.IsZero()) {
+                    T slack = -entry.Value() - u[i0] - v[j];
+                    if (!reached[j] || slack < min_slack[j]) {
+                        min_slack[j] = slack;
+                        reached[j] = true;
+                        way[j] = j0;
+                    }
+                }
+                if (reached[j] && (j1 == 0 || min_slack[j] < min_slack[j1]))
+                    j1 = j;
+            }
+            if (j1 == 0)
+                return false;   // the rows in the tree see fewer columns than there are rows
+
+            const T delta = min_slack[j1];
+            for (size_t j = 0; j <= n; ++j) {
+                if (used[j]) {
+                    u[owner[j]] += delta;
+                    v[j] -= delta;
+                } else if (reached[j]) {
+                    min_slack[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (owner[j0] != 0);
+
+        do {
+            const size_t j1 = way[j0];
+            owner[j0] = owner[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    match.assign(n, 0);
+    for (size_t j = 1; j <= n; ++j)
+        match[owner[j] - 1] = j - 1;
+    return true;
+}
+
+template<typename F>
+F MatrixView<F>::TropicalDeterminant() const {
+    using T = typename tropical_value<F>::type;
+    std::vector<size_t> match;
+    std::vector<T> u, v;
+    if (!max_weight_assignment(*this, match, u, v))
+        return F();
+    F det = F(0);
+    for (size_t i = 0; i < Rows(); ++i)
+        det = det * (*this)(i, match[i]);
+    return det;
+}
+
+/*
+    The optimal permutations are exactly the perfect matchings on the pairs
+    where the optimal duals are tight. Another one exists iff the tight
+    pairs outside the assignment close a cycle alternating with it: an arc
+    i -> k for each tight pair (i, match[k]), k != i, searched for by DFS.
+*/
+template<typename F>
+bool MatrixView<F>::TropicallySingular() const {
+    using T = typename tropical_value<F>::type;
+    const size_t n = Rows();
+    std::vector<size_t> match;
+    std::vector<T> u, v;
+    if (!max_weight_assignment(*this, match, u, v))
+        return true;
+
+    std::vector<size_t> row_of(n);
+    for (size_t i = 0; i < n; ++i)
+        row_of[match[i]] = i;
+    std::vector<char> state(n, 0);  // 0 unvisited, 1 on the DFS stack, 2 done
+    std::vector<std::pair<size_t, size_t>> stack;   // (row, next column to try)
+    for (size_t start = 0; start < n; ++start) {
+        if (state[start] != 0)
+            continue;
+        state[start] = 1;
+        stack.emplace_back(start, 0);
+        while (!stack.empty()) {
+            const size_t i = stack.back().first;
+            const size_t j = stack.back().second++;
+            if (j == n) {
+                state[i] = 2;
+                stack.pop_back();
+                continue;
+            }
+            const F& entry = (*this)(i, j);
+            if (j == match[i] || entry.IsZero() || -entry.Value() - u[i + 1] - v[j + 1] != T(0))
+                continue;
+            const size_t k = row_of[j];
+            if (state[k] == 1)
+                return true;
+            if (state[k] == 0) {
+                state[k] = 1;
+                stack.emplace_back(k, 0);
+            }
+        }
+    }
+    return false;
+}
+
+template<typename F>
+F Matrix<F>::TropicalDeterminant() const {
+    return MatrixView<F>(*this).TropicalDeterminant();
+}
+
+template<typename F>
+bool Matrix<F>::TropicallySingular() const {
+    return MatrixView<F>(*this).TropicallySingular();
+}
+
+/*
+    Deleting a row and its assigned column from a non-singular minor leaves
+    a non-singular minor, since a second optimum of the smaller one would
+    extend to a second optimum of the larger. So the non-singular k x k
+    minors are searched level by level, growing those of size k - 1 by one
+    row and one column, and the rank is the last level that is not empty.
+*/
+template<typename F>
+size_t Matrix<F>::TropicalRank() const {
+    if (rows == cols && !TropicallySingular())
+        return rows;
+
+    using minor = std::pair<std::vector<size_t>, std::vector<size_t>>;
+    std::set<minor> level;
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < cols; ++j)
+            if (!data[i * cols + j].IsZero())
+                level.insert(minor({i}, {j}));
+
+    size_t rank = 0;
+    while (!level.empty()) {
+        ++rank;
+        std::set<minor> next, seen;
+        for (const minor& m : level) {
+            for (size_t i = 0; i < rows; ++i) {
+                if (std::binary_search(m.first.begin(), m.first.end(), i))
+                    continue;
+                for (size_t j = 0; j < cols; ++j) {
+                    if (std::binary_search(m.second.begin(), m.second.end(), j))
+                        continue;
+                    minor grown = m;
+                    grown.first.insert(std::lower_bound(grown.first.begin(), grown.first.end(), i), i);
+                    grown.second.insert(std::lower_bound(grown.second.begin(), grown.second.end(), j), j);
+                    if (seen.insert(grown).second && !MatrixView<F>(*this, grown.first, grown.second).TropicallySingular())
+                        next.insert(std::move(grown));
+                }
+            }
+        }
+        level = std::move(next);
     }
     return rank;
 }
 
 template<typename F>
 std::ostream& operator << (std::ostream& out, Matrix<F>& m) {
-    for (size_t i = 0; i < m.data.size(); ++i) {
-	for (auto& val : m.data[i]) {
+    for (size_t i = 0; i < m.rows; ++i) {
+	for (auto& val : m[i]) {
             out << val << '\t';
 	}
 	out << '\n' << '\n';
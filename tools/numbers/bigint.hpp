@@ -20,21 +20,39 @@
 #ifndef BIG_INT_HPP
 #define BIG_INT_HPP
 
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <vector>
 
 class BigInt {
-    std::string value;
+    // A number that fits in a long long is kept inline in `small` and never
+    // touches the heap. Larger numbers keep their magnitude in `value` (base
+    // 2^64, least significant limb first) and their sign in `sign`.
+    std::vector<uint64_t> value;
+    long long small;
     char sign;
+    bool is_small;
+
+    const uint64_t* limbs(uint64_t&) const;
+    size_t limbs_size() const;
+    char get_sign() const;
+    void normalize();
+    BigInt add_signed(const BigInt&, char) const;
+    BigInt& add_in_place(const BigInt&, char);
+    void assign_product(const BigInt&, const BigInt&);
 
     public:
         // Constructors:
         BigInt();
         BigInt(const BigInt&);
+        BigInt(BigInt&&) noexcept;
         BigInt(const long long&);
         BigInt(const std::string&);
 
         // Assignment operators:
         BigInt& operator=(const BigInt&);
+        BigInt& operator=(BigInt&&) noexcept;
         BigInt& operator=(const long long&);
         BigInt& operator=(const std::string&);
 
@@ -43,9 +61,12 @@ class BigInt {
         BigInt operator-() const;   // unary -
 
         // Binary arithmetic operators:
-        BigInt operator+(const BigInt&) const;
-        BigInt operator-(const BigInt&) const;
-        BigInt operator*(const BigInt&) const;
+        BigInt operator+(const BigInt&) const &;
+        BigInt operator-(const BigInt&) const &;
+        BigInt operator*(const BigInt&) const &;
+        BigInt operator+(const BigInt&) &&;     // reuses the storage of a temporary LHS
+        BigInt operator-(const BigInt&) &&;
+        BigInt operator*(const BigInt&) &&;
         BigInt operator/(const BigInt&) const;
         BigInt operator%(const BigInt&) const;
         BigInt operator+(const long long&) const;
@@ -76,6 +97,16 @@ class BigInt {
         BigInt& operator/=(const std::string&);
         BigInt& operator%=(const std::string&);
 
+        // Fused multiply-add operators:
+        BigInt& addmul(const BigInt&, const BigInt&);   // *this += a * b
+        BigInt& submul(const BigInt&, const BigInt&);   // *this -= a * b
+
+        // Exact division, *this /= num where num is known to divide *this:
+        BigInt& divexact(const BigInt&);
+
+        // Division with remainder, *this /= num truncated and the remainder in the second argument:
+        BigInt& divmod(const BigInt&, BigInt&);
+
         // Increment and decrement operators:
         BigInt& operator++();       // pre-increment
         BigInt& operator--();       // pre-decrement
@@ -111,9 +142,14 @@ class BigInt {
         int to_int() const;
         long to_long() const;
         long long to_long_long() const;
+        size_t bit_length() const;              // bits in the magnitude
+        uint64_t residue(uint64_t) const;       // *this mod m, in [0, m)
 
         // Random number generating functions:
         friend BigInt big_random(size_t);
+
+        // Math functions working on the limbs directly:
+        friend BigInt gcd(const BigInt&, const BigInt&);
 };
 
 #endif  // BIG_INT_HPP
@@ -128,110 +164,1148 @@ class BigInt {
 #ifndef BIG_INT_UTILITY_FUNCTIONS_HPP
 #define BIG_INT_UTILITY_FUNCTIONS_HPP
 
-#include <tuple>
 
+/*
+    is_valid_number
+    ---------------
+    Checks whether the given string is a valid integer.
+*/
+
+bool is_valid_number(const std::string& num) {
+    for (char digit : num)
+        if (digit < '0' or digit > '9')
+            return false;
+
+    return true;
+}
+
+
+/*
+    strip_leading_zeroes
+    --------------------
+    Strip the leading zeroes from a number represented as a string.
+*/
+
+void strip_leading_zeroes(std::string& num) {
+    size_t i;
+    for (i = 0; i < num.size(); i++)
+        if (num[i] != '0')
+            break;
+
+    if (i == num.size())
+        num = "0";
+    else
+        num = num.substr(i);
+}
+
+
+#endif  // BIG_INT_UTILITY_FUNCTIONS_HPP
+
+
+/*
+    ===========================================================================
+    Limb arithmetic
+    ===========================================================================
+    The magnitude of a BigInt is kept as a sequence of 64-bit limbs, least
+    significant limb first. A normalized magnitude has no leading zero limbs,
+    so zero is the empty sequence. The functions below operate on raw limb
+    arrays and know nothing about signs.
+*/
+
+#ifndef BIG_INT_LIMB_FUNCTIONS_HPP
+#define BIG_INT_LIMB_FUNCTIONS_HPP
+
+#include <algorithm>
+#include <cstring>
+
+
+typedef uint64_t limb_t;
+typedef unsigned __int128 double_limb_t;
+
+const int LIMB_BITS = 64;
+
+// Multiplication thresholds, in limbs of the shorter operand: below
+// KARATSUBA_THRESHOLD the schoolbook method is used, then Karatsuba up to
+// TOOM3_THRESHOLD, Toom-3 up to NTT_THRESHOLD and the number-theoretic
+// transform beyond that. The defaults were picked by timing balanced products
+// on x86-64 (GCC 12, -O2); they are variables so that they can be retuned for
+// other machines. The NTT only wins consistently from about 40k limbs: just
+// past each power of two its transform length doubles and Toom-3 is faster
+// again. Karatsuba needs at least 4 limbs to shrink its operands, so smaller
+// values of KARATSUBA_THRESHOLD are treated as 4.
+size_t KARATSUBA_THRESHOLD = 32;
+size_t TOOM3_THRESHOLD = 192;
+size_t NTT_THRESHOLD = 40000;
+
+// Division threshold, in limbs: when both the divisor and the quotient are at
+// least this long, division goes through a Newton reciprocal of the divisor
+// instead of Knuth's algorithm D. On the same machine the two break even at
+// about 4096 limbs and Newton is twice as fast from 8192. The recursion in
+// limbs_reciprocal needs at least 3 limbs, so smaller values are treated as 3.
+size_t NEWTON_DIVISION_THRESHOLD = 4096;
+
+
+/*
+    limbs_normalized_size
+    ---------------------
+    Returns the number of limbs in `num` without its leading zero limbs.
+*/
+
+size_t limbs_normalized_size(const limb_t* num, size_t size) {
+    while (size > 0 and num[size - 1] == 0)
+        size--;
+
+    return size;
+}
+
+
+/*
+    limbs_compare
+    -------------
+    Compares two normalized magnitudes, returning -1, 0 or 1.
+*/
+
+int limbs_compare(const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    if (a_size != b_size)
+        return a_size < b_size ? -1 : 1;
+    for (size_t i = a_size; i-- > 0; )
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+
+    return 0;
+}
+
+
+/*
+    limbs_add
+    ---------
+    Computes r = a + b for a_size >= b_size and returns the carry out of the
+    most significant limb. `r` holds a_size limbs and may coincide with `a` or
+    `b`.
+*/
+
+limb_t limbs_add(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    limb_t carry = 0;
+    size_t i = 0;
+    for (; i < b_size; i++) {
+        limb_t sum;
+        bool overflow = __builtin_add_overflow(a[i], b[i], &sum);
+        overflow |= __builtin_add_overflow(sum, carry, &sum);
+        r[i] = sum;
+        carry = overflow;
+    }
+    for (; i < a_size; i++) {
+        r[i] = a[i] + carry;
+        carry = carry and r[i] == 0;
+    }
+
+    return carry;
+}
+
+
+/*
+    limbs_sub
+    ---------
+    Computes r = a - b for a_size >= b_size and returns the borrow out of the
+    most significant limb. `r` holds a_size limbs and may coincide with `a` or
+    `b`.
+*/
+
+limb_t limbs_sub(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    limb_t borrow = 0;
+    size_t i = 0;
+    for (; i < b_size; i++) {
+        limb_t difference;
+        bool overflow = __builtin_sub_overflow(a[i], b[i], &difference);
+        overflow |= __builtin_sub_overflow(difference, borrow, &difference);
+        r[i] = difference;
+        borrow = overflow;
+    }
+    for (; i < a_size; i++) {
+        limb_t limb = a[i];
+        r[i] = limb - borrow;
+        borrow = borrow and limb == 0;
+    }
+
+    return borrow;
+}
+
+
+/*
+    limbs_mul_1
+    -----------
+    Computes r = a * b for a single limb `b` and returns the most significant
+    limb of the product. `r` holds size limbs and may coincide with `a`.
+*/
+
+limb_t limbs_mul_1(limb_t* r, const limb_t* a, size_t size, limb_t b) {
+    limb_t carry = 0;
+    for (size_t i = 0; i < size; i++) {
+        double_limb_t product = (double_limb_t) a[i] * b + carry;
+        r[i] = (limb_t) product;
+        carry = (limb_t) (product >> LIMB_BITS);
+    }
+
+    return carry;
+}
+
+
+/*
+    limbs_addmul_1
+    --------------
+    Computes r += a * b for a single limb `b` and returns the carry out of the
+    size limbs of `r`.
+*/
+
+limb_t limbs_addmul_1(limb_t* r, const limb_t* a, size_t size, limb_t b) {
+    limb_t carry = 0;
+    for (size_t i = 0; i < size; i++) {
+        double_limb_t product = (double_limb_t) a[i] * b + r[i] + carry;
+        r[i] = (limb_t) product;
+        carry = (limb_t) (product >> LIMB_BITS);
+    }
+
+    return carry;
+}
+
+
+/*
+    limbs_divrem_1
+    --------------
+    Divides `a` by a non-zero single limb `d`, storing the quotient in `q` and
+    returning the remainder. `q` holds size limbs and may coincide with `a`.
+*/
+
+limb_t limbs_divrem_1(limb_t* q, const limb_t* a, size_t size, limb_t d) {
+    double_limb_t remainder = 0;
+    for (size_t i = size; i-- > 0; ) {
+        remainder = (remainder << LIMB_BITS) | a[i];
+        q[i] = (limb_t) (remainder / d);
+        remainder %= d;
+    }
+
+    return (limb_t) remainder;
+}
+
+
+/*
+    limbs_submul_1
+    --------------
+    Computes r -= a * b for a single limb `b` and returns the borrow out of the
+    size limbs of `r`.
+*/
+
+limb_t limbs_submul_1(limb_t* r, const limb_t* a, size_t size, limb_t b) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < size; i++) {
+        double_limb_t product = (double_limb_t) a[i] * b + borrow;
+        limb_t low = (limb_t) product;
+        borrow = (limb_t) (product >> LIMB_BITS) + (r[i] < low);
+        r[i] -= low;
+    }
+
+    return borrow;
+}
+
+
+/*
+    limbs_lshift
+    ------------
+    Computes r = a << shift for 0 <= shift < LIMB_BITS and returns the bits
+    shifted out of the most significant limb. `r` holds size limbs and may
+    coincide with `a`.
+*/
+
+limb_t limbs_lshift(limb_t* r, const limb_t* a, size_t size, unsigned shift) {
+    if (shift == 0) {
+        std::memmove(r, a, size * sizeof(limb_t));
+        return 0;
+    }
+
+    limb_t out = 0;
+    for (size_t i = 0; i < size; i++) {
+        limb_t limb = a[i];
+        r[i] = (limb << shift) | out;
+        out = limb >> (LIMB_BITS - shift);
+    }
+
+    return out;
+}
+
+
+/*
+    limbs_rshift
+    ------------
+    Computes r = a >> shift for 0 <= shift < LIMB_BITS. `r` holds size limbs
+    and may coincide with `a`.
+*/
+
+void limbs_rshift(limb_t* r, const limb_t* a, size_t size, unsigned shift) {
+    if (shift == 0) {
+        std::memmove(r, a, size * sizeof(limb_t));
+        return;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        limb_t next = i + 1 < size ? a[i + 1] : 0;
+        r[i] = (a[i] >> shift) | (next << (LIMB_BITS - shift));
+    }
+}
+
+
+/*
+    limbs_mul_basecase
+    ------------------
+    Schoolbook multiplication r = a * b for a_size >= b_size >= 1. `r` holds
+    a_size + b_size limbs and must not overlap the operands.
+*/
+
+void limbs_mul_basecase(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    r[a_size] = limbs_mul_1(r, a, a_size, b[0]);
+    for (size_t i = 1; i < b_size; i++)
+        r[a_size + i] = limbs_addmul_1(r + i, a, a_size, b[i]);
+}
+
+
+void limbs_mul(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size);
+
+
+/*
+    limbs_mul_karatsuba
+    -------------------
+    Karatsuba multiplication r = a * b for half < b_size <= a_size, where
+    half = ceil(a_size / 2). `r` holds a_size + b_size limbs and must not
+    overlap the operands.
+*/
+
+void limbs_mul_karatsuba(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    // a = a1 * B^half + a0, b = b1 * B^half + b0
+    size_t half = (a_size + 1) / 2;
+    const limb_t *a0 = a, *a1 = a + half, *b0 = b, *b1 = b + half;
+    size_t a1_size = a_size - half, b1_size = b_size - half;
+
+    std::vector<limb_t> a_sum(half + 1), b_sum(half + 1), middle(2 * half + 2);
+    a_sum[half] = limbs_add(a_sum.data(), a0, half, a1, a1_size);
+    b_sum[half] = limbs_add(b_sum.data(), b0, half, b1, b1_size);
+
+    limbs_mul(r, a0, half, b0, half);
+    limbs_mul(r + 2 * half, a1, a1_size, b1, b1_size);
+    limbs_mul(middle.data(), a_sum.data(), half + 1, b_sum.data(), half + 1);
+
+    // middle = (a0 + a1)(b0 + b1) - a0 b0 - a1 b1
+    limbs_sub(middle.data(), middle.data(), middle.size(), r, 2 * half);
+    limbs_sub(middle.data(), middle.data(), middle.size(), r + 2 * half, a1_size + b1_size);
+
+    size_t middle_size = limbs_normalized_size(middle.data(), middle.size());
+    limbs_add(r + half, r + half, a_size + b_size - half, middle.data(), middle_size);
+}
+
+
+/*
+    toom3_evaluate
+    --------------
+    Writes a0 + point * a1 + point^2 * a2 to the piece_size + 1 limbs of `r`,
+    where `a` is split into pieces a0 and a1 of piece_size limbs and a top
+    piece a2 of a2_size limbs.
+*/
+
+void toom3_evaluate(limb_t* r, const limb_t* a, size_t piece_size, size_t a2_size, limb_t point) {
+    std::memcpy(r, a, piece_size * sizeof(limb_t));
+    r[piece_size] = limbs_addmul_1(r, a + piece_size, piece_size, point);
+    limb_t carry = limbs_addmul_1(r, a + 2 * piece_size, a2_size, point * point);
+    limbs_add(r + a2_size, r + a2_size, piece_size + 1 - a2_size, &carry, 1);
+}
+
+
+/*
+    limbs_mul_toom3
+    ---------------
+    Toom-3 multiplication r = a * b for 2 * k < b_size <= a_size, where
+    k = ceil(a_size / 3). Both operands are split into three pieces of k limbs
+    and the product polynomial c4 x^4 + ... + c0 is evaluated at 0, 1, 2, 3 and
+    infinity. With non-negative points only, interpolating by finite
+    differences never produces a negative intermediate, so it runs on plain
+    limb arrays. `r` holds a_size + b_size limbs and must not overlap the
+    operands.
+*/
+
+void limbs_mul_toom3(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    size_t k = (a_size + 2) / 3;
+    size_t a2_size = a_size - 2 * k, b2_size = b_size - 2 * k;
+    size_t width = 2 * k + 2;
+
+    std::vector<limb_t> v0(width), v1(width), v2(width), v3(width), v_inf(width);
+    std::vector<limb_t> a_value(k + 1), b_value(k + 1), scratch(width);
+
+    limbs_mul(v0.data(), a, k, b, k);
+    if (a2_size >= b2_size)
+        limbs_mul(v_inf.data(), a + 2 * k, a2_size, b + 2 * k, b2_size);
+    else
+        limbs_mul(v_inf.data(), b + 2 * k, b2_size, a + 2 * k, a2_size);
+
+    limb_t* values[] = {v1.data(), v2.data(), v3.data()};
+    for (limb_t point = 1; point <= 3; point++) {
+        toom3_evaluate(a_value.data(), a, k, a2_size, point);
+        toom3_evaluate(b_value.data(), b, k, b2_size, point);
+        limbs_mul(values[point - 1], a_value.data(), k + 1, b_value.data(), k + 1);
+    }
+
+    // first differences: v3 = c1 + 5 c2 + 19 c3 + 65 c4,
+    // v2 = c1 + 3 c2 + 7 c3 + 15 c4, v1 = c1 + c2 + c3 + c4
+    limbs_sub(v3.data(), v3.data(), width, v2.data(), width);
+    limbs_sub(v2.data(), v2.data(), width, v1.data(), width);
+    limbs_sub(v1.data(), v1.data(), width, v0.data(), width);
+
+    // halved second differences: v3 = c2 + 6 c3 + 25 c4, v2 = c2 + 3 c3 + 7 c4
+    limbs_sub(v3.data(), v3.data(), width, v2.data(), width);
+    limbs_divrem_1(v3.data(), v3.data(), width, 2);
+    limbs_sub(v2.data(), v2.data(), width, v1.data(), width);
+    limbs_divrem_1(v2.data(), v2.data(), width, 2);
+
+    // third difference: v3 = c3 + 6 c4
+    limbs_sub(v3.data(), v3.data(), width, v2.data(), width);
+    limbs_divrem_1(v3.data(), v3.data(), width, 3);
+
+    // back substitution: v3 = c3, v2 = c2, v1 = c1
+    limbs_mul_1(scratch.data(), v_inf.data(), width, 6);
+    limbs_sub(v3.data(), v3.data(), width, scratch.data(), width);
+    limbs_mul_1(scratch.data(), v_inf.data(), width, 7);
+    limbs_sub(v2.data(), v2.data(), width, scratch.data(), width);
+    limbs_mul_1(scratch.data(), v3.data(), width, 3);
+    limbs_sub(v2.data(), v2.data(), width, scratch.data(), width);
+    limbs_sub(v1.data(), v1.data(), width, v2.data(), width);
+    limbs_sub(v1.data(), v1.data(), width, v3.data(), width);
+    limbs_sub(v1.data(), v1.data(), width, v_inf.data(), width);
+
+    // r = c0 + c1 B^k + c2 B^2k + c3 B^3k + c4 B^4k
+    std::memset(r, 0, (a_size + b_size) * sizeof(limb_t));
+    const limb_t* coefficients[] = {v0.data(), v1.data(), v2.data(), v3.data(), v_inf.data()};
+    for (size_t i = 0; i < 5; i++) {
+        size_t size = limbs_normalized_size(coefficients[i], width);
+        limbs_add(r + i * k, r + i * k, a_size + b_size - i * k, coefficients[i], size);
+    }
+}
+
+
+/*
+    ntt_prime
+    ---------
+    A prime p = c * 2^50 + 1 below 2^62 with roots of unity of every order up
+    to 2^50, for number-theoretic transforms of that length. Residues are kept in Montgomery
+    form x * 2^64 mod p, so that a modular product costs two multiplications
+    instead of a 128-bit division.
+*/
+
+struct ntt_prime {
+    static const int MAX_LOG_LENGTH = 50;
+
+    limb_t modulus;
+    limb_t inverse;         // -p^(-1) mod 2^64
+    limb_t r_squared;       // 2^128 mod p
+    limb_t roots[MAX_LOG_LENGTH + 1];           // roots[k] has order 2^k
+    limb_t inverse_roots[MAX_LOG_LENGTH + 1];
+
+    ntt_prime(limb_t modulus, limb_t generator) : modulus(modulus) {
+        // each Newton step doubles the number of correct low bits of p^(-1)
+        limb_t p_inverse = modulus;
+        for (int i = 0; i < 5; i++)
+            p_inverse *= 2 - modulus * p_inverse;
+        inverse = 0 - p_inverse;
+
+        limb_t r = (0 - modulus) % modulus;
+        r_squared = (limb_t) ((double_limb_t) r * r % modulus);
+
+        roots[MAX_LOG_LENGTH] = pow(to_montgomery(generator), (modulus - 1) >> MAX_LOG_LENGTH);
+        inverse_roots[MAX_LOG_LENGTH] = pow(roots[MAX_LOG_LENGTH], modulus - 2);
+        for (int k = MAX_LOG_LENGTH; k > 0; k--) {
+            roots[k - 1] = mul(roots[k], roots[k]);
+            inverse_roots[k - 1] = mul(inverse_roots[k], inverse_roots[k]);
+        }
+    }
+
+    limb_t reduce(double_limb_t t) const {
+        limb_t m = (limb_t) t * inverse;
+        limb_t u = (limb_t) ((t + (double_limb_t) m * modulus) >> LIMB_BITS);
+        return u >= modulus ? u - modulus : u;
+    }
+
+    limb_t mul(limb_t a, limb_t b) const {
+        return reduce((double_limb_t) a * b);
+    }
+
+    limb_t to_montgomery(limb_t a) const {
+        return mul(a % modulus, r_squared);
+    }
+
+    limb_t pow(limb_t base, limb_t exp) const {
+        limb_t result = to_montgomery(1);
+        for (; exp > 0; exp >>= 1) {
+            if (exp & 1)
+                result = mul(result, base);
+            base = mul(base, base);
+        }
+
+        return result;
+    }
+};
+
+
+/*
+    ntt_transform
+    -------------
+    In-place iterative number-theoretic transform of `a`, whose size is a power
+    of two, over the residues in Montgomery form modulo `p`. The inverse
+    transform includes the division by the size.
+*/
+
+void ntt_transform(std::vector<limb_t>& a, const ntt_prime& p, bool inverse) {
+    size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+
+    std::vector<limb_t> twiddles(n / 2);
+    for (int log_length = 1; ((size_t) 1 << log_length) <= n; log_length++) {
+        limb_t root = inverse ? p.inverse_roots[log_length] : p.roots[log_length];
+        size_t length = (size_t) 1 << log_length, half = length / 2;
+        twiddles[0] = p.to_montgomery(1);
+        for (size_t j = 1; j < half; j++)
+            twiddles[j] = p.mul(twiddles[j - 1], root);
+
+        for (size_t i = 0; i < n; i += length) {
+            for (size_t j = 0; j < half; j++) {
+                limb_t u = a[i + j], v = p.mul(a[i + j + half], twiddles[j]);
+                a[i + j] = u + v >= p.modulus ? u + v - p.modulus : u + v;
+                a[i + j + half] = u >= v ? u - v : u + p.modulus - v;
+            }
+        }
+    }
+
+    if (inverse) {
+        limb_t n_inverse = p.pow(p.to_montgomery(n), p.modulus - 2);
+        for (limb_t& x : a)
+            x = p.mul(x, n_inverse);
+    }
+}
+
+
+/*
+    limbs_mul_ntt
+    -------------
+    Multiplication r = a * b for a_size >= b_size >= 1 by convolving the limb
+    sequences modulo three 62-bit primes and recombining each coefficient by
+    the Chinese remainder theorem. A coefficient of the exact convolution is
+    below b_size * 2^128, well inside the 2^185 range of the three moduli.
+    `r` holds a_size + b_size limbs and must not overlap the operands.
+*/
+
+void limbs_mul_ntt(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    static const ntt_prime primes[3] = {
+        ntt_prime(4087ULL * (1ULL << 50) + 1, 3),
+        ntt_prime(4038ULL * (1ULL << 50) + 1, 10),
+        ntt_prime(4017ULL * (1ULL << 50) + 1, 37),
+    };
+
+    size_t n = 1;
+    while (n < a_size + b_size - 1)
+        n <<= 1;
+
+    std::vector<limb_t> residues[3];
+    std::vector<limb_t> b_transform(n);
+    for (int q = 0; q < 3; q++) {
+        const ntt_prime& p = primes[q];
+        std::vector<limb_t>& a_transform = residues[q];
+        a_transform.assign(n, 0);
+        std::fill(b_transform.begin(), b_transform.end(), 0);
+        for (size_t i = 0; i < a_size; i++)
+            a_transform[i] = p.to_montgomery(a[i]);
+        for (size_t i = 0; i < b_size; i++)
+            b_transform[i] = p.to_montgomery(b[i]);
+
+        ntt_transform(a_transform, p, false);
+        ntt_transform(b_transform, p, false);
+        for (size_t i = 0; i < n; i++)
+            a_transform[i] = p.mul(a_transform[i], b_transform[i]);
+        ntt_transform(a_transform, p, true);
+
+        // leave Montgomery form
+        for (size_t i = 0; i < n; i++)
+            a_transform[i] = p.reduce(a_transform[i]);
+    }
+
+    // Garner's constants, kept in Montgomery form so that multiplying a plain
+    // residue by them yields a plain residue
+    static const limb_t p1 = primes[0].modulus, p2 = primes[1].modulus, p3 = primes[2].modulus;
+    static const double_limb_t p1_p2 = (double_limb_t) p1 * p2;
+    static const limb_t p1_inverse_mod_p2 = primes[1].pow(primes[1].to_montgomery(p1), p2 - 2);
+    static const limb_t p1_mod_p3 = primes[2].to_montgomery(p1);
+    static const limb_t p1_p2_inverse_mod_p3 = primes[2].pow(primes[2].mul(p1_mod_p3, primes[2].to_montgomery(p2)), p3 - 2);
+
+    limb_t carry[3] = {0, 0, 0};
+    for (size_t i = 0; i < a_size + b_size; i++) {
+        if (i < n) {
+            // coefficient = x1 + x2 p1 + x3 p1 p2
+            limb_t x1 = residues[0][i];
+            limb_t x2 = residues[1][i] + p2 - x1 % p2;
+            x2 = primes[1].mul(x2 >= p2 ? x2 - p2 : x2, p1_inverse_mod_p2);
+            limb_t x3 = residues[2][i] + 2 * p3 - x1 % p3 - primes[2].mul(x2, p1_mod_p3);
+            x3 = primes[2].mul(x3 % p3, p1_p2_inverse_mod_p3);
+
+            double_limb_t low = (double_limb_t) x2 * p1 + x1;
+            double_limb_t high_low = (double_limb_t) x3 * (limb_t) p1_p2;
+            double_limb_t high_high = (double_limb_t) x3 * (limb_t) (p1_p2 >> LIMB_BITS);
+
+            limb_t term[3];
+            double_limb_t sum = (double_limb_t) (limb_t) low + (limb_t) high_low;
+            term[0] = (limb_t) sum;
+            sum = (sum >> LIMB_BITS) + (limb_t) (low >> LIMB_BITS) + (limb_t) (high_low >> LIMB_BITS) + (limb_t) high_high;
+            term[1] = (limb_t) sum;
+            term[2] = (limb_t) ((sum >> LIMB_BITS) + (high_high >> LIMB_BITS));
+            limbs_add(carry, carry, 3, term, 3);
+        }
+
+        r[i] = carry[0];
+        carry[0] = carry[1];
+        carry[1] = carry[2];
+        carry[2] = 0;
+    }
+}
+
+
+/*
+    limbs_mul
+    ---------
+    Computes r = a * b for a_size >= b_size >= 1, choosing between the
+    schoolbook method, Karatsuba, Toom-3 and the NTT by the size of `b` (see
+    KARATSUBA_THRESHOLD and the thresholds after it). `r` holds
+    a_size + b_size limbs and must not overlap the operands.
+*/
+
+void limbs_mul(limb_t* r, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    if (b_size < std::max<size_t>(KARATSUBA_THRESHOLD, 4)) {
+        limbs_mul_basecase(r, a, a_size, b, b_size);
+        return;
+    }
+    if (b_size >= NTT_THRESHOLD) {
+        limbs_mul_ntt(r, a, a_size, b, b_size);
+        return;
+    }
+
+    size_t half = (a_size + 1) / 2;
+    if (b_size <= half) {
+        // unbalanced operands: multiply `b` by b_size-limb pieces of `a`
+        std::memset(r, 0, (a_size + b_size) * sizeof(limb_t));
+        std::vector<limb_t> piece_product(2 * b_size);
+        for (size_t offset = 0; offset < a_size; offset += b_size) {
+            size_t piece_size = std::min(b_size, a_size - offset);
+            if (piece_size == b_size)
+                limbs_mul(piece_product.data(), a + offset, piece_size, b, b_size);
+            else
+                limbs_mul(piece_product.data(), b, b_size, a + offset, piece_size);
+            limbs_add(r + offset, r + offset, a_size + b_size - offset,
+                      piece_product.data(), piece_size + b_size);
+        }
+        return;
+    }
+
+    // Toom-3 needs all three pieces of `b` to be non-empty
+    if (b_size >= TOOM3_THRESHOLD and b_size > 2 * ((a_size + 2) / 3))
+        limbs_mul_toom3(r, a, a_size, b, b_size);
+    else
+        limbs_mul_karatsuba(r, a, a_size, b, b_size);
+}
+
+
+/*
+    limbs_divrem_knuth
+    ------------------
+    Schoolbook division (Knuth's algorithm D) of `a` by `b` for
+    a_size >= b_size >= 2. The divisor is shifted so that its top bit is set,
+    which makes the quotient limb estimated from the top two limbs of the
+    partial remainder at most two too large. Stores the normalized quotient
+    and remainder in `q` and `r`.
+*/
+
+void limbs_divrem_knuth(std::vector<limb_t>& q, std::vector<limb_t>& r,
+        const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    unsigned shift = __builtin_clzll(b[b_size - 1]);
+    std::vector<limb_t> d(b_size), u(a_size + 1);
+    limbs_lshift(d.data(), b, b_size, shift);
+    u[a_size] = limbs_lshift(u.data(), a, a_size, shift);
+
+    const limb_t d_top = d[b_size - 1], d_next = d[b_size - 2];
+    q.assign(a_size - b_size + 1, 0);
+    for (size_t j = a_size - b_size + 1; j-- > 0; ) {
+        double_limb_t numerator = ((double_limb_t) u[j + b_size] << LIMB_BITS) | u[j + b_size - 1];
+        double_limb_t q_hat = numerator / d_top, r_hat = numerator % d_top;
+        while ((q_hat >> LIMB_BITS) != 0
+                or (double_limb_t) (limb_t) q_hat * d_next > ((r_hat << LIMB_BITS) | u[j + b_size - 2])) {
+            q_hat--;
+            r_hat += d_top;
+            if ((r_hat >> LIMB_BITS) != 0)
+                break;
+        }
+
+        // u[j .. j + b_size] -= q_hat * d, adding d back if q_hat was one too large
+        limb_t borrow = limbs_submul_1(u.data() + j, d.data(), b_size, (limb_t) q_hat);
+        limb_t top = u[j + b_size];
+        u[j + b_size] = top - borrow;
+        if (top < borrow) {
+            q_hat--;
+            u[j + b_size] += limbs_add(u.data() + j, u.data() + j, b_size, d.data(), b_size);
+        }
+        q[j] = (limb_t) q_hat;
+    }
+
+    q.resize(limbs_normalized_size(q.data(), q.size()));
+    r.resize(b_size);
+    limbs_rshift(r.data(), u.data(), b_size, shift);
+    r.resize(limbs_normalized_size(r.data(), r.size()));
+}
+
+
+size_t newton_division_threshold() {
+    return std::max<size_t>(NEWTON_DIVISION_THRESHOLD, 3);
+}
+
+
+/*
+    limbs_reciprocal
+    ----------------
+    Sets `x` to floor(B^(2n) / b), n + 1 limbs, for an n-limb `b` whose top bit
+    is set (B = 2^64). The reciprocal of the top half of `b` is computed
+    recursively, refined by one Newton step x += x (B^(2n) - b x) / B^(2n) and
+    then corrected to the exact floor. Each level costs a few products of
+    about n by n / 2 limbs.
+*/
+
+void limbs_reciprocal(std::vector<limb_t>& x, const limb_t* b, size_t n) {
+    std::vector<limb_t> power(2 * n + 1, 0);
+    power[2 * n] = 1;
+    if (n < newton_division_threshold()) {
+        std::vector<limb_t> remainder;
+        limbs_divrem_knuth(x, remainder, power.data(), power.size(), b, n);
+        x.resize(n + 1);
+        return;
+    }
+
+    size_t h = (n + 1) / 2, l = n - h;
+    std::vector<limb_t> y;
+    limbs_reciprocal(y, b + l, h);
+
+    // the initial approximation is x = y B^l, so b x = (b y) B^l
+    std::vector<limb_t> product(2 * n + 2, 0), error(2 * n + 2, 0);
+    limbs_mul(product.data() + l, b, n, y.data(), h + 1);
+    bool too_large = limbs_compare(product.data(), limbs_normalized_size(product.data(), product.size()),
+                                   power.data(), power.size()) > 0;
+    if (too_large)
+        limbs_sub(error.data(), product.data(), product.size(), power.data(), power.size());
+    else
+        limbs_sub(error.data(), power.data(), power.size(), product.data(), power.size());
+
+    // Newton step: x = y B^l -+ y error / B^(2n - l). Dropping the low n - 1
+    // limbs of the error costs less than one unit, which the exact correction
+    // below absorbs.
+    const limb_t* error_high = error.data() + n - 1;
+    size_t error_high_size = limbs_normalized_size(error_high, error.size() - (n - 1));
+    x.assign(n + 2, 0);
+    std::copy(y.begin(), y.end(), x.begin() + l);
+    std::vector<limb_t> correction;
+    if (error_high_size > 0) {
+        std::vector<limb_t> step(h + 1 + error_high_size);
+        if (h + 1 >= error_high_size)
+            limbs_mul(step.data(), y.data(), h + 1, error_high, error_high_size);
+        else
+            limbs_mul(step.data(), error_high, error_high_size, y.data(), h + 1);
+        if (step.size() > h + 1)
+            correction.assign(step.begin() + h + 1, step.end());
+        correction.resize(limbs_normalized_size(correction.data(), correction.size()));
+    }
+    if (!correction.empty()) {
+        // keep b x up to date: b x -+= b correction
+        std::vector<limb_t> b_correction(n + correction.size());
+        if (n >= correction.size())
+            limbs_mul(b_correction.data(), b, n, correction.data(), correction.size());
+        else
+            limbs_mul(b_correction.data(), correction.data(), correction.size(), b, n);
+        size_t b_correction_size = limbs_normalized_size(b_correction.data(), b_correction.size());
+        if (too_large) {
+            limbs_sub(x.data(), x.data(), x.size(), correction.data(), correction.size());
+            limbs_sub(product.data(), product.data(), product.size(), b_correction.data(), b_correction_size);
+        }
+        else {
+            limbs_add(x.data(), x.data(), x.size(), correction.data(), correction.size());
+            limbs_add(product.data(), product.data(), product.size(), b_correction.data(), b_correction_size);
+        }
+    }
+
+    // make x exact: b x <= B^(2n) < b (x + 1)
+    const limb_t one = 1;
+    while (limbs_compare(product.data(), limbs_normalized_size(product.data(), product.size()),
+                         power.data(), power.size()) > 0) {
+        limbs_sub(x.data(), x.data(), x.size(), &one, 1);
+        limbs_sub(product.data(), product.data(), product.size(), b, n);
+    }
+    while (true) {
+        limbs_sub(error.data(), power.data(), power.size(), product.data(), power.size());
+        if (limbs_compare(error.data(), limbs_normalized_size(error.data(), power.size()), b, n) < 0)
+            break;
+        limbs_add(x.data(), x.data(), x.size(), &one, 1);
+        limbs_add(product.data(), product.data(), product.size(), b, n);
+    }
+    x.resize(n + 1);
+}
+
+
+/*
+    limbs_divrem_newton
+    -------------------
+    Division of `a` by `b` for long divisors. After normalizing `b`, the
+    dividend is consumed from the top in blocks of n = b_size limbs; each block
+    quotient is the top half of the partial remainder times the reciprocal of
+    `b`, which is never too large and at most three too small, followed by a
+    few corrections. The cost is O(M(n)) per block. Stores the normalized
+    quotient and remainder in `q` and `r`.
+*/
+
+void limbs_divrem_newton(std::vector<limb_t>& q, std::vector<limb_t>& r,
+        const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    size_t n = b_size;
+    unsigned shift = __builtin_clzll(b[n - 1]);
+    std::vector<limb_t> d(n), dividend(a_size + 1);
+    limbs_lshift(d.data(), b, n, shift);
+    dividend[a_size] = limbs_lshift(dividend.data(), a, a_size, shift);
+    size_t total = limbs_normalized_size(dividend.data(), dividend.size());
+
+    std::vector<limb_t> x;
+    limbs_reciprocal(x, d.data(), n);
+
+    const limb_t one = 1;
+    std::vector<limb_t> u(2 * n + 1), estimate(2 * n + 1), product(2 * n + 1);
+    q.assign(total, 0);
+    size_t block = total % n == 0 ? n : total % n;
+    for (size_t end = total; end > 0; end -= block, block = n) {
+        size_t start = end - block;
+
+        // u = remainder * B^block + dividend[start .. end)
+        std::copy_backward(u.begin(), u.begin() + n, u.begin() + block + n);
+        std::fill(u.begin() + block + n, u.end(), 0);
+        std::copy(dividend.begin() + start, dividend.begin() + end, u.begin());
+
+        // quotient limbs: floor(floor(u / B^n) x / B^n), then corrected
+        limbs_mul(estimate.data(), x.data(), n + 1, u.data() + n, n);
+        limb_t* q_block = estimate.data() + n;
+        limbs_mul(product.data(), q_block, n + 1, d.data(), n);
+        limbs_sub(u.data(), u.data(), u.size(), product.data(), product.size());
+        while (limbs_compare(u.data(), limbs_normalized_size(u.data(), u.size()), d.data(), n) >= 0) {
+            limbs_sub(u.data(), u.data(), u.size(), d.data(), n);
+            limbs_add(q_block, q_block, n + 1, &one, 1);
+        }
+        std::copy(q_block, q_block + block, q.begin() + start);
+    }
+
+    q.resize(limbs_normalized_size(q.data(), q.size()));
+    r.resize(n);
+    limbs_rshift(r.data(), u.data(), n, shift);
+    r.resize(limbs_normalized_size(r.data(), r.size()));
+}
+
+
+/*
+    limbs_divrem
+    ------------
+    Divides the normalized magnitude `a` by the non-zero normalized magnitude
+    `b`, storing the normalized quotient and remainder in `q` and `r`. Uses
+    Knuth's algorithm D, or the Newton reciprocal above
+    NEWTON_DIVISION_THRESHOLD.
+*/
+
+void limbs_divrem(std::vector<limb_t>& q, std::vector<limb_t>& r,
+        const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    if (limbs_compare(a, a_size, b, b_size) < 0) {
+        q.clear();
+        r.assign(a, a + a_size);
+        return;
+    }
+    if (b_size == 1) {
+        q.resize(a_size);
+        limb_t remainder = limbs_divrem_1(q.data(), a, a_size, b[0]);
+        q.resize(limbs_normalized_size(q.data(), q.size()));
+        r.clear();
+        if (remainder != 0)
+            r.push_back(remainder);
+        return;
+    }
+
+    if (b_size >= newton_division_threshold() and a_size - b_size >= newton_division_threshold())
+        limbs_divrem_newton(q, r, a, a_size, b, b_size);
+    else
+        limbs_divrem_knuth(q, r, a, a_size, b, b_size);
+}
+
+
+/*
+    limbs_divexact
+    --------------
+    Stores in `q` the normalized quotient of `a` by `b`, where `b` is known to
+    divide `a`. Quotient limbs are found from the least significant end by
+    multiplying with the inverse of the lowest divisor limb modulo 2^64
+    (Jebelean's exact division), so no quotient limb has to be estimated and
+    only the low a_size - b_size + 1 limbs of the dividend are ever updated.
+*/
+
+void limbs_divexact(std::vector<limb_t>& q, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    if (a_size < b_size) {
+        q.clear();
+        return;
+    }
+    if (b_size >= newton_division_threshold() and a_size - b_size >= newton_division_threshold()) {
+        std::vector<limb_t> remainder;
+        limbs_divrem_newton(q, remainder, a, a_size, b, b_size);
+        return;
+    }
+
+    // strip the factors of two of `b`, which `a` shares
+    while (b[0] == 0) {
+        a++, a_size--;
+        b++, b_size--;
+    }
+    unsigned shift = __builtin_ctzll(b[0]);
+    size_t q_size = a_size - b_size + 1;
+    std::vector<limb_t> u(q_size + 1, 0), d(b_size);
+    limbs_rshift(d.data(), b, b_size, shift);
+    b_size = limbs_normalized_size(d.data(), b_size);
+    limbs_rshift(u.data(), a, std::min(a_size, q_size + 1), shift);
+
+    // each Newton step doubles the number of correct low bits of d[0]^(-1)
+    limb_t inverse = d[0];
+    for (int i = 0; i < 5; i++)
+        inverse *= 2 - d[0] * inverse;
+
+    q.resize(q_size);
+    for (size_t i = 0; i < q_size; i++) {
+        limb_t q_limb = u[i] * inverse;
+        q[i] = q_limb;
+        size_t length = std::min(b_size, q_size - i);
+        limb_t borrow = limbs_submul_1(u.data() + i, d.data(), length, q_limb);
+        for (size_t j = i + length; borrow != 0 and j < q_size; j++) {
+            limb_t limb = u[j];
+            u[j] = limb - borrow;
+            borrow = limb < borrow;
+        }
+    }
+    q.resize(limbs_normalized_size(q.data(), q.size()));
+}
+
+/*
+    limb_gcd
+    --------
+    Returns the greatest common divisor of two limbs by the binary method.
+*/
+
+limb_t limb_gcd(limb_t a, limb_t b) {
+    if (a == 0)
+        return b;
+    if (b == 0)
+        return a;
+
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    while (b != 0) {
+        b >>= __builtin_ctzll(b);
+        if (a > b)
+            std::swap(a, b);
+        b -= a;
+    }
+
+    return a << shift;
+}
+
+
+/*
+    limbs_combine
+    -------------
+    Computes r = x * p - y * q for single limbs `x` and `y`, where the result
+    is known to be non-negative, and normalizes it.
+*/
+
+void limbs_combine(std::vector<limb_t>& r, const std::vector<limb_t>& p, limb_t x,
+        const std::vector<limb_t>& q, limb_t y) {
+    size_t size = std::max(p.size(), q.size()) + 1;
+    r.assign(size, 0);
+    r[p.size()] = limbs_mul_1(r.data(), p.data(), p.size(), x);
+    limb_t borrow = limbs_submul_1(r.data(), q.data(), q.size(), y);
+    for (size_t i = q.size(); borrow != 0 and i < size; i++) {
+        limb_t limb = r[i];
+        r[i] = limb - borrow;
+        borrow = limb < borrow;
+    }
+    r.resize(limbs_normalized_size(r.data(), r.size()));
+}
+
+
+/*
+    limbs_gcd
+    ---------
+    Stores in `g` the normalized greatest common divisor of `a` and `b` using
+    Lehmer's algorithm: the Euclidean quotients are simulated on the leading 62
+    bits of both numbers, for as long as they provably agree with the true
+    ones, and the accumulated 2x2 cosequence matrix is then applied to the
+    full numbers in one linear pass. A division step is done only when the
+    leading bits yield no quotient, and the last single limb is handled by
+    the binary method.
+*/
+
+void limbs_gcd(std::vector<limb_t>& g, const limb_t* a, size_t a_size, const limb_t* b, size_t b_size) {
+    std::vector<limb_t> u(a, a + a_size), v(b, b + b_size), next_u, next_v;
+    if (limbs_compare(u.data(), u.size(), v.data(), v.size()) < 0)
+        u.swap(v);
+
+    while (v.size() > 1) {
+        // leading 62 bits of u and the bits of v at the same positions
+        size_t n = u.size();
+        unsigned shift = __builtin_clzll(u[n - 1]);
+        double_limb_t u_top = ((double_limb_t) u[n - 1] << LIMB_BITS) | u[n - 2];
+        double_limb_t v_top = ((double_limb_t) (v.size() == n ? v[n - 1] : 0) << LIMB_BITS)
+                              | (v.size() >= n - 1 ? v[n - 2] : 0);
+        int64_t x = (int64_t) ((u_top << shift) >> 66), y = (int64_t) ((v_top << shift) >> 66);
+
+        // Knuth's algorithm L: (A B; C D) maps (u, v) to the current pair
+        int64_t A = 1, B = 0, C = 0, D = 1;
+        while (y + C > 0 and y + D > 0) {
+            int64_t quotient = (x + A) / (y + C);
+            if (quotient != (x + B) / (y + D))
+                break;
+
+            int64_t t = A - quotient * C;
+            A = C, C = t;
+            t = B - quotient * D;
+            B = D, D = t;
+            t = x - quotient * y;
+            x = y, y = t;
+        }
 
-/*
-    is_valid_number
-    ---------------
-    Checks whether the given string is a valid integer.
-*/
+        if (B == 0) {
+            // no quotient could be simulated: take a full division step
+            std::vector<limb_t> quotient;
+            limbs_divrem(quotient, next_v, u.data(), u.size(), v.data(), v.size());
+            u.swap(v);
+            v.swap(next_v);
+            continue;
+        }
 
-bool is_valid_number(const std::string& num) {
-    for (char digit : num)
-        if (digit < '0' or digit > '9')
-            return false;
+        // the entries of each row have opposite signs (or one is zero)
+        if (B <= 0)
+            limbs_combine(next_u, u, A, v, -B);
+        else
+            limbs_combine(next_u, v, B, u, -A);
+        if (D <= 0)
+            limbs_combine(next_v, u, C, v, -D);
+        else
+            limbs_combine(next_v, v, D, u, -C);
+        u.swap(next_u);
+        v.swap(next_v);
+    }
 
-    return true;
+    if (v.empty()) {
+        g = u;
+        return;
+    }
+    limb_t remainder = limbs_divrem_1(u.data(), u.data(), u.size(), v[0]);
+    g.assign(1, limb_gcd(v[0], remainder));
 }
 
+#endif  // BIG_INT_LIMB_FUNCTIONS_HPP
+
 
 /*
-    strip_leading_zeroes
-    --------------------
-    Strip the leading zeroes from a number represented as a string.
+    ===========================================================================
+    Small and large forms
+    ===========================================================================
+    Arithmetic on two small numbers is done directly on `small` with overflow
+    checks; on overflow, or when either operand is large, both operands are
+    viewed as limb arrays and the result is normalized back to the small form
+    whenever it fits.
 */
 
-void strip_leading_zeroes(std::string& num) {
-    size_t i;
-    for (i = 0; i < num.size(); i++)
-        if (num[i] != '0')
-            break;
+#ifndef BIG_INT_REPRESENTATION_HPP
+#define BIG_INT_REPRESENTATION_HPP
 
-    if (i == num.size())
-        num = "0";
-    else
-        num = num.substr(i);
-}
+#include <climits>
 
 
 /*
-    add_leading_zeroes
-    ------------------
-    Adds a given number of leading zeroes to a string-represented integer `num`.
+    limbs
+    -----
+    Returns a pointer to the magnitude of the number as a limb array. A small
+    number's magnitude is written to `buffer`.
 */
 
-void add_leading_zeroes(std::string& num, size_t num_zeroes) {
-    num = std::string(num_zeroes, '0') + num;
+const limb_t* BigInt::limbs(limb_t& buffer) const {
+    if (!is_small)
+        return value.data();
+
+    // negate in unsigned arithmetic so that LLONG_MIN is handled as well
+    buffer = small < 0 ? 0 - (limb_t) small : (limb_t) small;
+    return &buffer;
 }
 
 
 /*
-    add_trailing_zeroes
-    -------------------
-    Adds a given number of trailing zeroes to a string-represented integer `num`.
+    limbs_size
+    ----------
+    Returns the number of limbs in the normalized magnitude of the number.
 */
 
-void add_trailing_zeroes(std::string& num, size_t num_zeroes) {
-    num += std::string(num_zeroes, '0');
+size_t BigInt::limbs_size() const {
+    if (is_small)
+        return small != 0;
+
+    return value.size();
 }
 
 
 /*
-    get_larger_and_smaller
-    ----------------------
-    Identifies the given string-represented integers as `larger` and `smaller`,
-    padding the smaller number with leading zeroes to make it equal in length to
-    the larger number.
+    get_sign
+    --------
+    Returns the sign of the number, '+' for zero.
 */
 
-std::tuple<std::string, std::string> get_larger_and_smaller(const std::string& num1,
-        const std::string& num2) {
-    std::string larger, smaller;
-    if (num1.size() > num2.size() or
-        (num1.size() == num2.size() and num1 > num2)) {
-        larger = num1;
-        smaller = num2;
-    }
-    else {
-        larger = num2;
-        smaller = num1;
-    }
-
-    // pad the smaller number with zeroes
-    add_leading_zeroes(smaller, larger.size() - smaller.size());
+char BigInt::get_sign() const {
+    if (is_small)
+        return small < 0 ? '-' : '+';
 
-    return std::make_tuple(larger, smaller);
+    return sign;
 }
 
 
 /*
-    is_power_of_10
-    ----------------------
-    Checks whether a string-represented integer is a power of 10.
+    normalize
+    ---------
+    Strips leading zero limbs from `value` and switches to the small form if
+    the number fits in a long long. The capacity of `value` is kept for reuse.
 */
 
-bool is_power_of_10(const std::string& num){
-    if (num[0] != '1')
-        return false;
-    for (size_t i = 1; i < num.size(); i++)
-        if (num[i] != '0')
-            return false;
+void BigInt::normalize() {
+    value.resize(limbs_normalized_size(value.data(), value.size()));
+    is_small = false;
+    if (value.size() > 1)
+        return;
 
-    return true;    // first digit is 1 and the following digits are all 0
+    limb_t magnitude = value.empty() ? 0 : value[0];
+    if (magnitude <= (limb_t) LLONG_MAX + (sign == '-')) {
+        small = sign == '-' ? (long long) (0 - magnitude) : (long long) magnitude;
+        is_small = true;
+        value.clear();
+    }
 }
 
-#endif  // BIG_INT_UTILITY_FUNCTIONS_HPP
+#endif  // BIG_INT_REPRESENTATION_HPP
 
 
 /*
@@ -265,17 +1339,17 @@ BigInt big_random(size_t num_digits = 0) {
         // use a random number for it:
         num_digits = 1 + rand_generator() % MAX_RANDOM_LENGTH;
 
-    BigInt big_rand;
-    big_rand.value = "";    // clear value to append digits
+    std::string digits;
 
     // ensure that the first digit is non-zero
-    big_rand.value += std::to_string(1 + rand_generator() % 9);
+    digits += std::to_string(1 + rand_generator() % 9);
 
-    while (big_rand.value.size() < num_digits)
-        big_rand.value += std::to_string(rand_generator());
-    if (big_rand.value.size() != num_digits)
-        big_rand.value.erase(num_digits);   // erase extra digits
+    while (digits.size() < num_digits)
+        digits += std::to_string(rand_generator());
+    if (digits.size() != num_digits)
+        digits.erase(num_digits);   // erase extra digits
 
+    BigInt big_rand(digits);
     return big_rand;
 }
 
@@ -300,8 +1374,9 @@ BigInt big_random(size_t num_digits = 0) {
 */
 
 BigInt::BigInt() {
-    value = "0";
+    small = 0;
     sign = '+';
+    is_small = true;
 }
 
 
@@ -312,7 +1387,27 @@ BigInt::BigInt() {
 
 BigInt::BigInt(const BigInt& num) {
     value = num.value;
+    small = num.small;
+    sign = num.sign;
+    is_small = num.is_small;
+}
+
+
+/*
+    Move constructor
+    ----------------
+    Takes over the limbs of `num`, leaving it equal to zero.
+*/
+
+BigInt::BigInt(BigInt&& num) noexcept {
+    value = std::move(num.value);
+    small = num.small;
     sign = num.sign;
+    is_small = num.is_small;
+
+    num.value.clear();
+    num.small = 0;
+    num.is_small = true;
 }
 
 
@@ -322,24 +1417,24 @@ BigInt::BigInt(const BigInt& num) {
 */
 
 BigInt::BigInt(const long long& num) {
-    value = std::to_string(std::abs(num));
-    if (num < 0)
-        sign = '-';
-    else
-        sign = '+';
+    small = num;
+    sign = '+';
+    is_small = true;
 }
 
 
 /*
     String to BigInt
     ----------------
+    The decimal digits are consumed in chunks of 19, each chunk being
+    multiplied into the magnitude with a single pass over its limbs.
 */
 
 BigInt::BigInt(const std::string& num) {
+    std::string magnitude;
     if (num[0] == '+' or num[0] == '-') {     // check for sign
-        std::string magnitude = num.substr(1);
+        magnitude = num.substr(1);
         if (is_valid_number(magnitude)) {
-            value = magnitude;
             sign = num[0];
         }
         else {
@@ -348,14 +1443,35 @@ BigInt::BigInt(const std::string& num) {
     }
     else {      // if no sign is specified
         if (is_valid_number(num)) {
-            value = num;
+            magnitude = num;
             sign = '+';    // positive by default
         }
         else {
             throw std::invalid_argument("Expected an integer, got \'" + num + "\'");
         }
     }
-    strip_leading_zeroes(value);
+    strip_leading_zeroes(magnitude);
+
+    const size_t CHUNK_DIGITS = 19;
+    size_t chunk_size = magnitude.size() % CHUNK_DIGITS;
+    if (chunk_size == 0)
+        chunk_size = CHUNK_DIGITS;
+    for (size_t i = 0; i < magnitude.size(); i += chunk_size, chunk_size = CHUNK_DIGITS) {
+        limb_t chunk = 0, chunk_base = 1;
+        for (size_t j = i; j < i + chunk_size; j++) {
+            chunk = chunk * 10 + (magnitude[j] - '0');
+            chunk_base *= 10;
+        }
+        limb_t carry = limbs_mul_1(value.data(), value.data(), value.size(), chunk_base);
+        if (carry != 0)
+            value.push_back(carry);
+        if (value.empty())
+            value.push_back(0);
+        carry = limbs_add(value.data(), value.data(), value.size(), &chunk, 1);
+        if (carry != 0)
+            value.push_back(carry);
+    }
+    normalize();
 }
 
 #endif  // BIG_INT_CONSTRUCTORS_HPP
@@ -370,16 +1486,37 @@ BigInt::BigInt(const std::string& num) {
 #ifndef BIG_INT_CONVERSION_FUNCTIONS_HPP
 #define BIG_INT_CONVERSION_FUNCTIONS_HPP
 
+#include <stdexcept>
+
 
 /*
     to_string
     ---------
-    Converts a BigInt to a string.
+    Converts a BigInt to a string. The magnitude is repeatedly divided by
+    10^19, producing 19 decimal digits per pass.
 */
 
 std::string BigInt::to_string() const {
+    if (is_small)
+        return std::to_string(small);
+
+    const limb_t CHUNK_BASE = 10000000000000000000ULL;     // 10^19
+    std::vector<limb_t> quotient = value;
+    std::vector<limb_t> chunks;
+    while (!quotient.empty()) {
+        chunks.push_back(limbs_divrem_1(quotient.data(), quotient.data(), quotient.size(), CHUNK_BASE));
+        quotient.resize(limbs_normalized_size(quotient.data(), quotient.size()));
+    }
+
     // prefix with sign if negative
-    return this->sign == '-' ? "-" + this->value : this->value;
+    std::string result = sign == '-' ? "-" : "";
+    result += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0; ) {
+        std::string chunk = std::to_string(chunks[i]);
+        result += std::string(19 - chunk.size(), '0') + chunk;
+    }
+
+    return result;
 }
 
 
@@ -387,12 +1524,16 @@ std::string BigInt::to_string() const {
     to_int
     ------
     Converts a BigInt to an int.
-    NOTE: If the BigInt is out of range of an int, stoi() will throw an
-    out_of_range exception.
+    NOTE: If the BigInt is out of range of an int, an out_of_range exception
+    is thrown.
 */
 
 int BigInt::to_int() const {
-    return std::stoi(this->to_string());
+    long long num = this->to_long_long();
+    if (num < INT_MIN or num > INT_MAX)
+        throw std::out_of_range("BigInt is out of range of an int");
+
+    return (int) num;
 }
 
 
@@ -400,12 +1541,16 @@ int BigInt::to_int() const {
     to_long
     -------
     Converts a BigInt to a long int.
-    NOTE: If the BigInt is out of range of a long int, stol() will throw an
-    out_of_range exception.
+    NOTE: If the BigInt is out of range of a long int, an out_of_range
+    exception is thrown.
 */
 
 long BigInt::to_long() const {
-    return std::stol(this->to_string());
+    long long num = this->to_long_long();
+    if (num < LONG_MIN or num > LONG_MAX)
+        throw std::out_of_range("BigInt is out of range of a long");
+
+    return (long) num;
 }
 
 
@@ -413,12 +1558,54 @@ long BigInt::to_long() const {
     to_long_long
     ------------
     Converts a BigInt to a long long int.
-    NOTE: If the BigInt is out of range of a long long int, stoll() will throw
-    an out_of_range exception.
+    NOTE: If the BigInt is out of range of a long long int, an out_of_range
+    exception is thrown.
 */
 
 long long BigInt::to_long_long() const {
-    return std::stoll(this->to_string());
+    if (!is_small)
+        throw std::out_of_range("BigInt is out of range of a long long");
+
+    return small;
+}
+
+
+/*
+    bit_length
+    ----------
+    Returns the number of bits in the magnitude of a BigInt, 0 for zero.
+*/
+
+size_t BigInt::bit_length() const {
+    limb_t buffer;
+    const limb_t* num = limbs(buffer);
+    size_t size = limbs_size();
+    if (size == 0)
+        return 0;
+
+    return size * LIMB_BITS - __builtin_clzll(num[size - 1]);
+}
+
+
+/*
+    residue
+    -------
+    Returns the least non-negative residue of a BigInt modulo a machine word,
+    reading the limbs directly instead of going through a BigInt division.
+    NOTE: modulus should be positive.
+*/
+
+uint64_t BigInt::residue(uint64_t modulus) const {
+    limb_t buffer;
+    const limb_t* num = limbs(buffer);
+    double_limb_t remainder = 0;
+    for (size_t i = limbs_size(); i-- > 0; )
+        remainder = ((remainder << LIMB_BITS) | num[i]) % modulus;
+
+    if (get_sign() == '-' && remainder != 0)
+        remainder = modulus - remainder;
+
+    return (uint64_t) remainder;
 }
 
 #endif  // BIG_INT_CONVERSION_FUNCTIONS_HPP
@@ -442,7 +1629,29 @@ long long BigInt::to_long_long() const {
 
 BigInt& BigInt::operator=(const BigInt& num) {
     value = num.value;
+    small = num.small;
+    sign = num.sign;
+    is_small = num.is_small;
+
+    return *this;
+}
+
+
+/*
+    BigInt = BigInt&&
+    -----------------
+    Exchanges storage with `num`, which is left equal to zero.
+*/
+
+BigInt& BigInt::operator=(BigInt&& num) noexcept {
+    value.swap(num.value);
+    small = num.small;
     sign = num.sign;
+    is_small = num.is_small;
+
+    num.value.clear();
+    num.small = 0;
+    num.is_small = true;
 
     return *this;
 }
@@ -454,9 +1663,10 @@ BigInt& BigInt::operator=(const BigInt& num) {
 */
 
 BigInt& BigInt::operator=(const long long& num) {
-    BigInt temp(num);
-    value = temp.value;
-    sign = temp.sign;
+    value.clear();
+    small = num;
+    sign = '+';
+    is_small = true;
 
     return *this;
 }
@@ -468,9 +1678,7 @@ BigInt& BigInt::operator=(const long long& num) {
 */
 
 BigInt& BigInt::operator=(const std::string& num) {
-    BigInt temp(num);
-    value = temp.value;
-    sign = temp.sign;
+    *this = BigInt(num);
 
     return *this;
 }
@@ -511,14 +1719,17 @@ BigInt BigInt::operator+() const {
 BigInt BigInt::operator-() const {
     BigInt temp;
 
-    temp.value = value;
-    if (value != "0") {
-        if (sign == '+')
-            temp.sign = '-';
-        else
-            temp.sign = '+';
+    if (is_small and small != LLONG_MIN) {
+        temp.small = -small;
+        return temp;
     }
 
+    limb_t buffer;
+    const limb_t* magnitude = limbs(buffer);
+    temp.value.assign(magnitude, magnitude + limbs_size());
+    temp.sign = get_sign() == '+' ? '-' : '+';
+    temp.normalize();
+
     return temp;
 }
 
@@ -543,6 +1754,9 @@ BigInt BigInt::operator-() const {
 */
 
 bool BigInt::operator==(const BigInt& num) const {
+    if (is_small or num.is_small)
+        return is_small and num.is_small and small == num.small;
+
     return (sign == num.sign) and (value == num.value);
 }
 
@@ -563,18 +1777,20 @@ bool BigInt::operator!=(const BigInt& num) const {
 */
 
 bool BigInt::operator<(const BigInt& num) const {
-    if (sign == num.sign) {
-        if (sign == '+') {
-            if (value.length() == num.value.length())
-                return value < num.value;
-            else
-                return value.length() < num.value.length();
-        }
+    if (is_small and num.is_small)
+        return small < num.small;
+
+    char this_sign = get_sign(), num_sign = num.get_sign();
+    if (this_sign == num_sign) {
+        limb_t buffer, num_buffer;
+        int comparison = limbs_compare(limbs(buffer), limbs_size(), num.limbs(num_buffer), num.limbs_size());
+        if (this_sign == '+')
+            return comparison < 0;
         else
-            return -(*this) > -num;
+            return comparison > 0;
     }
     else
-        return sign == '-';
+        return this_sign == '-';
 }
 
 
@@ -980,28 +2196,29 @@ BigInt sqrt(const BigInt& num) {
 /*
     gcd(BigInt, BigInt)
     -------------------
-    Returns the greatest common divisor (GCD, a.k.a. HCF) of two BigInts using
-    Euclid's algorithm.
+    Returns the greatest common divisor (GCD, a.k.a. HCF) of two BigInts,
+    using the binary method for small numbers and Lehmer's algorithm for
+    large ones.
 */
 
 BigInt gcd(const BigInt &num1, const BigInt &num2){
-    BigInt abs_num1 = abs(num1);
-    BigInt abs_num2 = abs(num2);
-
-    // base cases:
-    if (abs_num2 == 0)
-        return abs_num1;    // gcd(a, 0) = |a|
-    if (abs_num1 == 0)
-        return abs_num2;    // gcd(0, a) = |a|
-
-    BigInt remainder = abs_num2;
-    while (remainder != 0) {
-        remainder = abs_num1 % abs_num2;
-        abs_num1 = abs_num2;    // previous remainder
-        abs_num2 = remainder;   // current remainder
+    limb_t buffer1, buffer2;
+    const limb_t* a = num1.limbs(buffer1);
+    const limb_t* b = num2.limbs(buffer2);
+    size_t a_size = num1.limbs_size(), b_size = num2.limbs_size();
+
+    BigInt result;
+    if (a_size <= 1 and b_size <= 1) {
+        limb_t divisor = limb_gcd(a_size == 0 ? 0 : a[0], b_size == 0 ? 0 : b[0]);
+        result.value.assign(1, divisor);
     }
+    else
+        limbs_gcd(result.value, a, a_size, b, b_size);
+    result.sign = '+';
+    result.is_small = false;
+    result.normalize();
 
-    return abs_num1;
+    return result;
 }
 
 
@@ -1055,7 +2272,7 @@ BigInt lcm(const BigInt& num1, const BigInt& num2) {
     if (num1 == 0 or num2 == 0)
         return 0;
 
-    return abs(num1 * num2) / gcd(num1, num2);
+    return abs(num1 * num2).divexact(gcd(num1, num2));
 }
 
 
@@ -1112,289 +2329,239 @@ BigInt lcm(const std::string& num1, const BigInt& num2){
 #define BIG_INT_BINARY_ARITHMETIC_OPERATORS_HPP
 
 #include <climits>
-#include <cmath>
 #include <string>
 
 
-const long long FLOOR_SQRT_LLONG_MAX = 3037000499;
-
 
 /*
-    BigInt + BigInt
-    ---------------
-    The operand on the RHS of the addition is `num`.
+    add_signed
+    ----------
+    Helper function that returns *this + num, with `num_sign` used in place of
+    the sign of `num`. Both addition and subtraction reduce to it.
 */
 
-BigInt BigInt::operator+(const BigInt& num) const {
-    // if the operands are of opposite signs, perform subtraction
-    if (this->sign == '+' and num.sign == '-') {
-        BigInt rhs = num;
-        rhs.sign = '+';
-        return *this - rhs;
-    }
-    else if (this->sign == '-' and num.sign == '+') {
-        BigInt lhs = *this;
-        lhs.sign = '+';
-        return -(lhs - num);
-    }
-
-    // identify the numbers as `larger` and `smaller`
-    std::string larger, smaller;
-    std::tie(larger, smaller) = get_larger_and_smaller(this->value, num.value);
+BigInt BigInt::add_signed(const BigInt& num, char num_sign) const {
+    limb_t buffer, num_buffer;
+    const limb_t* a = limbs(buffer);
+    const limb_t* b = num.limbs(num_buffer);
+    size_t a_size = limbs_size(), b_size = num.limbs_size();
+    char a_sign = get_sign();
 
-    BigInt result;      // the resultant sum
-    result.value = "";  // the value is cleared as the digits will be appended
-    short carry = 0, sum;
-    // add the two values
-    for (long i = larger.size() - 1; i >= 0; i--) {
-        sum = larger[i] - '0' + smaller[i] - '0' + carry;
-        result.value = std::to_string(sum % 10) + result.value;
-        carry = sum / (short) 10;
+    BigInt result;
+    if (a_sign == num_sign) {
+        if (a_size < b_size) {
+            std::swap(a, b);
+            std::swap(a_size, b_size);
+        }
+        result.value.resize(a_size + 1);
+        result.value.back() = limbs_add(result.value.data(), a, a_size, b, b_size);
+        result.sign = a_sign;
     }
-    if (carry)
-        result.value = std::to_string(carry) + result.value;
-
-    // if the operands are negative, the result is negative
-    if (this->sign == '-' and result.value != "0")
-        result.sign = '-';
+    else {
+        int comparison = limbs_compare(a, a_size, b, b_size);
+        if (comparison == 0)
+            return result;
+
+        // subtract the smaller magnitude from the larger one
+        if (comparison < 0) {
+            std::swap(a, b);
+            std::swap(a_size, b_size);
+        }
+        result.value.resize(a_size);
+        limbs_sub(result.value.data(), a, a_size, b, b_size);
+        result.sign = comparison > 0 ? a_sign : num_sign;
+    }
+    result.normalize();
 
     return result;
 }
 
 
 /*
-    BigInt - BigInt
-    ---------------
-    The operand on the RHS of the subtraction is `num`.
+    add_in_place
+    ------------
+    Helper function that adds `num`, with `num_sign` used in place of its sign,
+    to *this. The limbs are updated in place, so no memory is allocated unless
+    the magnitude outgrows the capacity of `value`.
 */
 
-BigInt BigInt::operator-(const BigInt& num) const {
-    // if the operands are of opposite signs, perform addition
-    if (this->sign == '+' and num.sign == '-') {
-        BigInt rhs = num;
-        rhs.sign = '+';
-        return *this + rhs;
-    }
-    else if (this->sign == '-' and num.sign == '+') {
-        BigInt lhs = *this;
-        lhs.sign = '+';
-        return -(lhs + num);
+BigInt& BigInt::add_in_place(const BigInt& num, char num_sign) {
+    if (this == &num) {
+        BigInt copy = num;
+        return add_in_place(copy, num_sign);
     }
 
-    BigInt result;      // the resultant difference
-    // identify the numbers as `larger` and `smaller`
-    std::string larger, smaller;
-    if (abs(*this) > abs(num)) {
-        larger = this->value;
-        smaller = num.value;
+    limb_t num_buffer;
+    const limb_t* b = num.limbs(num_buffer);
+    size_t b_size = num.limbs_size();
+
+    if (is_small) {
+        // switch to the large form, reusing the capacity of `value`
+        limb_t buffer;
+        limb_t magnitude = *limbs(buffer);
+        sign = get_sign();
+        value.clear();
+        if (magnitude != 0)
+            value.push_back(magnitude);
+        is_small = false;
+    }
+    size_t a_size = value.size();
 
-        if (this->sign == '-')      // -larger - -smaller = -result
-            result.sign = '-';
+    if (sign == num_sign) {
+        value.resize(std::max(a_size, b_size) + 1);
+        if (a_size >= b_size)
+            value[a_size] = limbs_add(value.data(), value.data(), a_size, b, b_size);
+        else
+            value[b_size] = limbs_add(value.data(), b, b_size, value.data(), a_size);
+    }
+    else if (limbs_compare(value.data(), a_size, b, b_size) >= 0) {
+        limbs_sub(value.data(), value.data(), a_size, b, b_size);
     }
     else {
-        larger = num.value;
-        smaller = this->value;
-
-        if (num.sign == '+')        // smaller - larger = -result
-            result.sign = '-';
-    }
-    // pad the smaller number with zeroes
-    add_leading_zeroes(smaller, larger.size() - smaller.size());
-
-    result.value = "";  // the value is cleared as the digits will be appended
-    short difference;
-    long i, j;
-    // subtract the two values
-    for (i = larger.size() - 1; i >= 0; i--) {
-        difference = larger[i] - smaller[i];
-        if (difference < 0) {
-            for (j = i - 1; j >= 0; j--) {
-                if (larger[j] != '0') {
-                    larger[j]--;    // borrow from the j-th digit
-                    break;
-                }
-            }
-            j++;
-            while (j != i) {
-                larger[j] = '9';    // add the borrow and take away 1
-                j++;
-            }
-            difference += 10;   // add the borrow
-        }
-        result.value = std::to_string(difference) + result.value;
+        value.resize(b_size);
+        limbs_sub(value.data(), b, b_size, value.data(), a_size);
+        sign = num_sign;
     }
-    strip_leading_zeroes(result.value);
+    normalize();
 
-    // if the result is 0, set its sign as +
-    if (result.value == "0")
-        result.sign = '+';
-
-    return result;
+    return *this;
 }
 
 
 /*
-    BigInt * BigInt
-    ---------------
-    Computes the product of two BigInts using Karatsuba's algorithm.
-    The operand on the RHS of the product is `num`.
+    assign_product
+    --------------
+    Helper function that sets *this to a * b, reusing the capacity of `value`.
+    Neither operand may be *this.
 */
 
-BigInt BigInt::operator*(const BigInt& num) const {
-    if (*this == 0 or num == 0)
-        return BigInt(0);
-    if (*this == 1)
-        return num;
-    if (num == 1)
-     return *this;
-
-    BigInt product;
-    if (abs(*this) <= FLOOR_SQRT_LLONG_MAX and abs(num) <= FLOOR_SQRT_LLONG_MAX)
-        product = std::stoll(this->value) * std::stoll(num.value);
-    else if (is_power_of_10(this->value)){ // if LHS is a power of 10 do optimised operation 
-        product.value = num.value;
-        product.value.append(this->value.begin() + 1, this->value.end());
+void BigInt::assign_product(const BigInt& a, const BigInt& b) {
+    long long small_product;
+    if (a.is_small and b.is_small and !__builtin_mul_overflow(a.small, b.small, &small_product)) {
+        value.clear();
+        small = small_product;
+        is_small = true;
+        return;
     }
-    else if (is_power_of_10(num.value)){ // if RHS is a power of 10 do optimised operation 
-        product.value = this->value;
-        product.value.append(num.value.begin() + 1, num.value.end());
+
+    limb_t a_buffer, b_buffer;
+    const limb_t* a_limbs = a.limbs(a_buffer);
+    const limb_t* b_limbs = b.limbs(b_buffer);
+    size_t a_size = a.limbs_size(), b_size = b.limbs_size();
+    if (a_size < b_size) {
+        std::swap(a_limbs, b_limbs);
+        std::swap(a_size, b_size);
     }
-    else {
-        // identify the numbers as `larger` and `smaller`
-        std::string larger, smaller;
-        std::tie(larger, smaller) = get_larger_and_smaller(this->value, num.value);
 
-        size_t half_length = larger.size() / 2;
-        auto half_length_ceil = (size_t) ceil(larger.size() / 2.0);
+    value.resize(a_size + b_size);
+    if (b_size == 0)
+        value.clear();
+    else
+        limbs_mul(value.data(), a_limbs, a_size, b_limbs, b_size);
 
-        BigInt num1_high, num1_low;
-        num1_high = larger.substr(0, half_length);
-        num1_low = larger.substr(half_length);
+    if (a.get_sign() == b.get_sign())
+        sign = '+';
+    else
+        sign = '-';
+    normalize();
+}
 
-        BigInt num2_high, num2_low;
-        num2_high = smaller.substr(0, half_length);
-        num2_low = smaller.substr(half_length);
 
-        strip_leading_zeroes(num1_high.value);
-        strip_leading_zeroes(num1_low.value);
-        strip_leading_zeroes(num2_high.value);
-        strip_leading_zeroes(num2_low.value);
+/*
+    BigInt + BigInt
+    ---------------
+    The operand on the RHS of the addition is `num`.
+*/
 
-        BigInt prod_high, prod_mid, prod_low;
-        prod_high = num1_high * num2_high;
-        prod_low = num1_low * num2_low;
-        prod_mid = (num1_high + num1_low) * (num2_high + num2_low)
-                   - prod_high - prod_low;
+BigInt BigInt::operator+(const BigInt& num) const & {
+    long long sum;
+    if (is_small and num.is_small and !__builtin_add_overflow(small, num.small, &sum))
+        return BigInt(sum);
 
-        add_trailing_zeroes(prod_high.value, 2 * half_length_ceil);
-        add_trailing_zeroes(prod_mid.value, half_length_ceil);
+    return add_signed(num, num.get_sign());
+}
 
-        strip_leading_zeroes(prod_high.value);
-        strip_leading_zeroes(prod_mid.value);
-        strip_leading_zeroes(prod_low.value);
 
-        product = prod_high + prod_mid + prod_low;
-    }
-    strip_leading_zeroes(product.value);
+/*
+    BigInt - BigInt
+    ---------------
+    The operand on the RHS of the subtraction is `num`.
+*/
 
-    if (this->sign == num.sign)
-        product.sign = '+';
-    else
-        product.sign = '-';
+BigInt BigInt::operator-(const BigInt& num) const & {
+    long long difference;
+    if (is_small and num.is_small and !__builtin_sub_overflow(small, num.small, &difference))
+        return BigInt(difference);
+
+    return add_signed(num, num.get_sign() == '+' ? '-' : '+');
+}
+
+
+/*
+    BigInt * BigInt
+    ---------------
+    Computes the product of two BigInts (see limbs_mul for the algorithms).
+    The operand on the RHS of the product is `num`.
+*/
+
+BigInt BigInt::operator*(const BigInt& num) const & {
+    BigInt product;
+    product.assign_product(*this, num);
 
     return product;
 }
 
 
 /*
-    divide
-    ------
-    Helper function that returns the quotient and remainder on dividing the
-    dividend by the divisor, when the divisor is 1 to 10 times the dividend.
+    BigInt&& + BigInt, BigInt&& - BigInt, BigInt&& * BigInt
+    -------------------------------------------------------
+    When the LHS is a temporary, the operation is done in place on it and the
+    result is moved out, recycling its limbs.
 */
 
-std::tuple<BigInt, BigInt> divide(const BigInt& dividend, const BigInt& divisor) {
-    BigInt quotient, remainder, temp;
+BigInt BigInt::operator+(const BigInt& num) && {
+    *this += num;
 
-    temp = divisor;
-    quotient = 1;
-    while (temp < dividend) {
-        quotient++;
-        temp += divisor;
-    }
-    if (temp > dividend) {
-        quotient--;
-        remainder = dividend - (temp - divisor);
-    }
+    return std::move(*this);
+}
 
-    return std::make_tuple(quotient, remainder);
+BigInt BigInt::operator-(const BigInt& num) && {
+    *this -= num;
+
+    return std::move(*this);
+}
+
+BigInt BigInt::operator*(const BigInt& num) && {
+    *this *= num;
+
+    return std::move(*this);
 }
 
 
 /*
     BigInt / BigInt
     ---------------
-    Computes the quotient of two BigInts using the long-division method.
+    Computes the quotient of two BigInts (see limbs_divrem for the algorithms).
     The operand on the RHS of the division (the divisor) is `num`.
 */
 
 BigInt BigInt::operator/(const BigInt& num) const {
-    BigInt abs_dividend = abs(*this);
-    BigInt abs_divisor = abs(num);
-
-    if (num == 0)
+    if (num.is_small and num.small == 0)
         throw std::logic_error("Attempted division by zero");
-    if (abs_dividend < abs_divisor)
-        return BigInt(0);
-    if (num == 1)
-        return *this;
-    if (num == -1)
-        return -(*this);
+    // LLONG_MIN / -1 is the only quotient of two small numbers that overflows
+    if (is_small and num.is_small and !(small == LLONG_MIN and num.small == -1))
+        return BigInt(small / num.small);
 
-    BigInt quotient;
-    if (abs_dividend <= LLONG_MAX and abs_divisor <= LLONG_MAX)
-        quotient = std::stoll(abs_dividend.value) / std::stoll(abs_divisor.value);
-    else if (abs_dividend == abs_divisor)
-        quotient = 1;
-    else if (is_power_of_10(abs_divisor.value)) { // if divisor is a power of 10 do optimised calculation
-        size_t digits_in_quotient = abs_dividend.value.size() - abs_divisor.value.size() + 1;
-        quotient.value = abs_dividend.value.substr(0, digits_in_quotient);
-    }
-    else {
-        quotient.value = "";    // the value is cleared as digits will be appended
-        BigInt chunk, chunk_quotient, chunk_remainder;
-        size_t chunk_index = 0;
-        chunk_remainder.value = abs_dividend.value.substr(chunk_index, abs_divisor.value.size() - 1);
-        chunk_index = abs_divisor.value.size() - 1;
-        while (chunk_index < abs_dividend.value.size()) {
-            chunk.value = chunk_remainder.value.append(1, abs_dividend.value[chunk_index]);
-            chunk_index++;
-            while (chunk < abs_divisor) {
-                quotient.value += "0";
-                if (chunk_index < abs_dividend.value.size()) {
-                    chunk.value.append(1, abs_dividend.value[chunk_index]);
-                    chunk_index++;
-                }
-                else
-                    break;
-            }
-            if (chunk == abs_divisor) {
-                quotient.value += "1";
-                chunk_remainder = 0;
-            }
-            else if (chunk > abs_divisor) {
-                strip_leading_zeroes(chunk.value);
-                std::tie(chunk_quotient, chunk_remainder) = divide(chunk, abs_divisor);
-                quotient.value += chunk_quotient.value;
-            }
-        }
-    }
-    strip_leading_zeroes(quotient.value);
+    limb_t buffer, num_buffer;
+    BigInt quotient, remainder;
+    limbs_divrem(quotient.value, remainder.value, limbs(buffer), limbs_size(),
+                 num.limbs(num_buffer), num.limbs_size());
 
-    if (this->sign == num.sign)
+    if (get_sign() == num.get_sign())
         quotient.sign = '+';
     else
         quotient.sign = '-';
+    quotient.normalize();
 
     return quotient;
 }
@@ -1408,33 +2575,19 @@ BigInt BigInt::operator/(const BigInt& num) const {
 */
 
 BigInt BigInt::operator%(const BigInt& num) const {
-    BigInt abs_dividend = abs(*this);
-    BigInt abs_divisor = abs(num);
-
-    if (abs_divisor == 0)
+    if (num.is_small and num.small == 0)
         throw std::logic_error("Attempted division by zero");
-    if (abs_divisor == 1 or abs_divisor == abs_dividend)
-        return BigInt(0);
-
-    BigInt remainder;
-    if (abs_dividend <= LLONG_MAX and abs_divisor <= LLONG_MAX)
-        remainder = std::stoll(abs_dividend.value) % std::stoll(abs_divisor.value);
-    else if (abs_dividend < abs_divisor)
-        remainder = abs_dividend;
-    else if (is_power_of_10(num.value)){ // if num is a power of 10 use optimised calculation
-        size_t no_of_zeroes = num.value.size() - 1;
-        remainder.value = abs_dividend.value.substr(abs_dividend.value.size() - no_of_zeroes);
-    } 
-    else {
-        BigInt quotient = abs_dividend / abs_divisor;
-        remainder = abs_dividend - quotient * abs_divisor;
-    }
-    strip_leading_zeroes(remainder.value);
+    if (is_small and num.is_small)
+        return BigInt(num.small == -1 ? 0 : small % num.small);
+
+    limb_t buffer, num_buffer;
+    BigInt quotient, remainder;
+    limbs_divrem(quotient.value, remainder.value, limbs(buffer), limbs_size(),
+                 num.limbs(num_buffer), num.limbs_size());
 
     // remainder has the same sign as that of the dividend
-    remainder.sign = this->sign;
-    if (remainder.value == "0")     // except if its zero
-        remainder.sign = '+';
+    remainder.sign = get_sign();
+    remainder.normalize();
 
     return remainder;
 }
@@ -1659,9 +2812,13 @@ BigInt operator%(const std::string& lhs, const BigInt& rhs) {
 */
 
 BigInt& BigInt::operator+=(const BigInt& num) {
-    *this = *this + num;
+    long long sum;
+    if (is_small and num.is_small and !__builtin_add_overflow(small, num.small, &sum)) {
+        small = sum;
+        return *this;
+    }
 
-    return *this;
+    return add_in_place(num, num.get_sign());
 }
 
 
@@ -1671,9 +2828,13 @@ BigInt& BigInt::operator+=(const BigInt& num) {
 */
 
 BigInt& BigInt::operator-=(const BigInt& num) {
-    *this = *this - num;
+    long long difference;
+    if (is_small and num.is_small and !__builtin_sub_overflow(small, num.small, &difference)) {
+        small = difference;
+        return *this;
+    }
 
-    return *this;
+    return add_in_place(num, num.get_sign() == '+' ? '-' : '+');
 }
 
 
@@ -1683,7 +2844,20 @@ BigInt& BigInt::operator-=(const BigInt& num) {
 */
 
 BigInt& BigInt::operator*=(const BigInt& num) {
-    *this = *this * num;
+    long long product;
+    if (is_small and num.is_small and !__builtin_mul_overflow(small, num.small, &product)) {
+        small = product;
+        return *this;
+    }
+
+    // the product is built in a per-thread buffer whose storage is then
+    // exchanged with ours, so neither allocates once warmed up
+    static thread_local BigInt product_buffer;
+    product_buffer.assign_product(*this, num);
+    value.swap(product_buffer.value);
+    small = product_buffer.small;
+    sign = product_buffer.sign;
+    is_small = product_buffer.is_small;
 
     return *this;
 }
@@ -1832,6 +3006,117 @@ BigInt& BigInt::operator%=(const std::string& num) {
     return *this;
 }
 
+
+
+/*
+    BigInt += BigInt * BigInt
+    -------------------------
+    Fused multiply-add: adds the product a * b to *this. The product is kept
+    in a per-thread buffer, so the operation does not allocate once the
+    buffer and `value` have grown large enough.
+*/
+
+BigInt& BigInt::addmul(const BigInt& a, const BigInt& b) {
+    long long product, sum;
+    if (is_small and a.is_small and b.is_small and !__builtin_mul_overflow(a.small, b.small, &product)
+            and !__builtin_add_overflow(small, product, &sum)) {
+        small = sum;
+        return *this;
+    }
+
+    static thread_local BigInt product_buffer;
+    product_buffer.assign_product(a, b);
+
+    return add_in_place(product_buffer, product_buffer.get_sign());
+}
+
+
+/*
+    BigInt -= BigInt * BigInt
+    -------------------------
+    Fused multiply-subtract: subtracts the product a * b from *this. Like
+    `addmul`, it does not allocate in the steady state.
+*/
+
+BigInt& BigInt::submul(const BigInt& a, const BigInt& b) {
+    long long product, difference;
+    if (is_small and a.is_small and b.is_small and !__builtin_mul_overflow(a.small, b.small, &product)
+            and !__builtin_sub_overflow(small, product, &difference)) {
+        small = difference;
+        return *this;
+    }
+
+    static thread_local BigInt product_buffer;
+    product_buffer.assign_product(a, b);
+
+    return add_in_place(product_buffer, product_buffer.get_sign() == '+' ? '-' : '+');
+}
+
+
+/*
+    BigInt /= BigInt (exact)
+    ------------------------
+    Divides *this by `num`, which must divide it. Exact division needs no
+    quotient estimates or remainder, so it is cheaper than operator/=; if `num`
+    does not divide *this, the result is meaningless.
+*/
+
+BigInt& BigInt::divexact(const BigInt& num) {
+    if (num.is_small and num.small == 0)
+        throw std::logic_error("Attempted division by zero");
+    if (is_small and num.is_small and !(small == LLONG_MIN and num.small == -1)) {
+        small /= num.small;
+        return *this;
+    }
+
+    static thread_local std::vector<limb_t> quotient;
+    limb_t buffer, num_buffer;
+    limbs_divexact(quotient, limbs(buffer), limbs_size(), num.limbs(num_buffer), num.limbs_size());
+
+    if (get_sign() == num.get_sign())
+        sign = '+';
+    else
+        sign = '-';
+    value.swap(quotient);
+    is_small = false;
+    normalize();
+
+    return *this;
+}
+
+
+/*
+    BigInt /= BigInt (with remainder)
+    ---------------------------------
+    Divides *this by `num`, truncating as operator/= does, and stores the
+    remainder, which has the sign of the dividend, in `remainder`. One call
+    to limbs_divrem gives both.
+*/
+
+BigInt& BigInt::divmod(const BigInt& num, BigInt& remainder) {
+    if (num.is_small and num.small == 0)
+        throw std::logic_error("Attempted division by zero");
+    if (is_small and num.is_small and !(small == LLONG_MIN and num.small == -1)) {
+        remainder = BigInt(small % num.small);
+        small /= num.small;
+        return *this;
+    }
+
+    limb_t buffer, num_buffer;
+    BigInt quotient;
+    remainder = BigInt();
+    limbs_divrem(quotient.value, remainder.value, limbs(buffer), limbs_size(),
+                 num.limbs(num_buffer), num.limbs_size());
+
+    remainder.sign = get_sign();
+    remainder.normalize();
+    quotient.sign = get_sign() == num.get_sign() ? '+' : '-';
+    quotient.normalize();
+    *this = std::move(quotient);
+
+    return *this;
+}
+
 #endif  // BIG_INT_ARITHMETIC_ASSIGNMENT_OPERATORS_HPP
 
 
@@ -1933,9 +3218,7 @@ std::istream& operator>>(std::istream& in, BigInt& num) {
 */
 
 std::ostream& operator<<(std::ostream& out, const BigInt& num) {
-    if (num.sign == '-')
-        out << num.sign;
-    out << num.value;
+    out << num.to_string();
 
     return out;
 }
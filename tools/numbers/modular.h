@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <random>
+
+// Arithmetic modulo a machine word. Moduli are below 2^63, so a sum of two
+// residues never overflows and products go through a 128-bit intermediate.
+
+uint64_t add_mod(uint64_t a, uint64_t b, uint64_t modulus) {
+    uint64_t sum = a + b;
+    return sum >= modulus ? sum - modulus : sum;
+}
+
+uint64_t sub_mod(uint64_t a, uint64_t b, uint64_t modulus) {
+    return a >= b ? a - b : a + modulus - b;
+}
+
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t modulus) {
+    return (uint64_t) ((unsigned __int128) a * b % modulus);
+}
+
+uint64_t pow_mod(uint64_t base, uint64_t exp, uint64_t modulus) {
+    uint64_t result = 1 % modulus;
+    base %= modulus;
+    for (; exp != 0; exp >>= 1) {
+        if (exp & 1)
+            result = mul_mod(result, base, modulus);
+        base = mul_mod(base, base, modulus);
+    }
+    return result;
+}
+
+// Inverse of a residue coprime to the modulus, by the extended Euclidean algorithm
+uint64_t inverse_mod(uint64_t a, uint64_t modulus) {
+    // invariant: r0 = s0 * a and r1 = s1 * a modulo the modulus, with |s| < modulus
+    int64_t s0 = 0, s1 = 1;
+    uint64_t r0 = modulus, r1 = a % modulus;
+    while (r1 != 0) {
+        uint64_t q = r0 / r1;
+        uint64_t r = r0 - q * r1;
+        int64_t s = s0 - (int64_t) q * s1;
+        r0 = r1, r1 = r;
+        s0 = s1, s1 = s;
+    }
+    return s0 < 0 ? (uint64_t) (s0 + (int64_t) modulus) : (uint64_t) s0;
+}
+
+/*
+    Montgomery arithmetic modulo an odd modulus below 2^63. A residue x is
+    kept as x * 2^64 mod p, so that a product costs two multiplications and
+    a shift instead of a 128-bit division.
+*/
+struct montgomery {
+    uint64_t modulus = 1;
+    uint64_t inverse = 0;       // -p^(-1) mod 2^64
+    uint64_t r_squared = 0;     // 2^128 mod p
+
+    // Written as single return expressions, as C++11 requires of constexpr functions: Zp<P> builds its parameters at compile time
+    constexpr explicit montgomery(uint64_t modulus) : modulus(modulus), inverse(0 - newton_inverse(modulus, modulus, 5)), r_squared(square_mod((0 - modulus) % modulus, modulus)) {
+    }
+
+    // Each Newton step x *= 2 - p x doubles the number of correct low bits of p^(-1) mod 2^64, starting from the three of x = p
+    static constexpr uint64_t newton_inverse(uint64_t p, uint64_t x, int steps) {
+        return steps == 0 ? x : newton_inverse(p, x * (2 - p * x), steps - 1);
+    }
+
+    static constexpr uint64_t square_mod(uint64_t r, uint64_t p) {
+        return (uint64_t) ((unsigned __int128) r * r % p);
+    }
+
+    constexpr uint64_t reduce(unsigned __int128 t) const {
+        return subtract_once((uint64_t) ((t + (unsigned __int128) ((uint64_t) t * inverse) * modulus) >> 64));
+    }
+
+    constexpr uint64_t subtract_once(uint64_t u) const {
+        return u >= modulus ? u - modulus : u;
+    }
+
+    constexpr uint64_t mul(uint64_t a, uint64_t b) const {
+        return reduce((unsigned __int128) a * b);
+    }
+
+    constexpr uint64_t to_montgomery(uint64_t a) const {
+        return mul(a % modulus, r_squared);
+    }
+
+    constexpr uint64_t from_montgomery(uint64_t a) const {
+        return reduce(a);
+    }
+};
+
+// Deterministic Miller-Rabin: the first twelve prime bases decide every n < 2^64
+bool is_prime(uint64_t n) {
+    static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    if (n < 2)
+        return false;
+    for (uint64_t p : bases)
+        if (n % p == 0)
+            return n == p;
+
+    uint64_t d = n - 1;
+    int s = 0;
+    for (; (d & 1) == 0; d >>= 1)
+        ++s;
+    for (uint64_t a : bases) {
+        uint64_t x = pow_mod(a, d, n);
+        if (x == 1 || x == n - 1)
+            continue;
+        bool composite = true;
+        for (int r = 1; r < s && composite; ++r) {
+            x = mul_mod(x, x, n);
+            composite = x != n - 1;
+        }
+        if (composite)
+            return false;
+    }
+    return true;
+}
+
+// Uniformly random prime with exactly `bits` bits, 2 < bits < 64
+uint64_t random_prime(int bits, std::mt19937_64& generator) {
+    std::uniform_int_distribution<uint64_t> distribution(uint64_t(1) << (bits - 1), (uint64_t(1) << bits) - 1);
+    for (;;) {
+        uint64_t candidate = distribution(generator) | 1;
+        if (is_prime(candidate))
+            return candidate;
+    }
+}
@@ -3,14 +3,19 @@
 #include <utility>
 #include "bigint.hpp"
 
+// A Rational is always kept in lowest terms with a positive denominator, so
+// that the arithmetic below can cancel common factors before multiplying.
 class Rational {
     BigInt numerator;
     BigInt denominator;
 
+    Rational& AddSigned(const Rational&, bool); // *this += rhs, or -= when the flag is set
+
 public:
     // Constructors:
     Rational();
     Rational(const Rational&);
+    Rational(Rational&&) noexcept;
     Rational(const long long&);
     Rational(const long long&, const long long&);
     Rational(const std::pair<long long, long long>&);
@@ -20,8 +25,13 @@ public:
     
     void Simplify();
 
+    // Components in lowest terms, the denominator positive:
+    const BigInt& Numerator() const;
+    const BigInt& Denominator() const;
+
     // Assignment operators:
     Rational& operator=(const Rational&);
+    Rational& operator=(Rational&&) noexcept;
     Rational& operator=(const long long&);
     Rational& operator=(const std::pair<long long, long long>&);
     Rational& operator=(const BigInt&);
@@ -33,10 +43,14 @@ public:
     Rational operator-() const;
 
     // Binary arithmetic operators:
-    Rational operator+(const Rational&) const;
-    Rational operator-(const Rational&) const;
-    Rational operator*(const Rational&) const;
-    Rational operator/(const Rational&) const;
+    Rational operator+(const Rational&) const &;
+    Rational operator-(const Rational&) const &;
+    Rational operator*(const Rational&) const &;
+    Rational operator/(const Rational&) const &;
+    Rational operator+(const Rational&) &&; // reuse a temporary left operand
+    Rational operator-(const Rational&) &&;
+    Rational operator*(const Rational&) &&;
+    Rational operator/(const Rational&) &&;
     Rational operator+(const long long&) const;
     Rational operator-(const long long&) const;
     Rational operator*(const long long&) const;
@@ -76,6 +90,9 @@ public:
     Rational& operator*=(const std::pair<BigInt, BigInt>&);
     Rational& operator/=(const std::pair<BigInt, BigInt>&);
 
+    // Fused multiply-subtract, *this -= a * b:
+    Rational& submul(const Rational&, const Rational&);
+
     // Increment and decrement operators:
     Rational& operator++();       // pre-increment
     Rational& operator--();       // pre-decrement
@@ -118,32 +135,25 @@ public:
 };
 
 
-// Euclidean algorithm to find gcd. We use it to make numerator and denominator coprime.
-BigInt EuclideanAlgorithm(BigInt a, BigInt b) {
-    if (a < b) {
-        std::swap(a, b);
-    }
-
-    while (b != 0) {
-	a = a % b;
-	std::swap(a, b);
-    }
-    return a;
-}
-
+// Makes numerator and denominator coprime, with the denominator positive. The gcd is Lehmer's (see bigint.hpp).
 void Rational::Simplify() {
     if (denominator < 0) {
         numerator *= -1;
         denominator *= -1;
     }
-    BigInt gcd;
-    if (numerator > 0) {
-        gcd = EuclideanAlgorithm(numerator, denominator);
-    } else {
-        gcd = EuclideanAlgorithm(-numerator, denominator);
+    const BigInt divisor = gcd(numerator, denominator);
+    if (divisor != 1) {
+        numerator.divexact(divisor);
+        denominator.divexact(divisor);
     }
-    numerator /= gcd;
-    denominator /= gcd;
+}
+
+const BigInt& Rational::Numerator() const {
+    return numerator;
+}
+
+const BigInt& Rational::Denominator() const {
+    return denominator;
 }
 
 // Constructors definition:
@@ -157,16 +167,22 @@ Rational::Rational(const Rational& number) {
     denominator = number.denominator;
 }
 
+Rational::Rational(Rational&& number) noexcept : numerator(std::move(number.numerator)), denominator(std::move(number.denominator)) {
+    number.denominator = 1;
+}
+
 Rational::Rational(const long long& number) : numerator(number) {
     denominator = 1;
 }
 
 Rational::Rational(const long long& numerator, const long long& denominator) : numerator(numerator), denominator(denominator) {
+    this->Simplify();
 }
 
 Rational::Rational(const std::pair<long long, long long>& pair) {
     numerator = pair.first;
     denominator = pair.second;
+    this->Simplify();
 }
 
 Rational::Rational(const BigInt& k) : numerator(k) {
@@ -174,11 +190,13 @@ Rational::Rational(const BigInt& k) : numerator(k) {
 }
 
 Rational::Rational(const BigInt& numerator, const BigInt& denominator) : numerator(numerator), denominator(denominator) {
+    this->Simplify();
 }
 
 Rational::Rational(const std::pair<BigInt, BigInt>& pair) {
     numerator = pair.first;
     denominator = pair.second;
+    this->Simplify();
 }
 
 // Assignment operators definition
@@ -188,6 +206,13 @@ Rational& Rational::operator=(const Rational& number) {
     return *this;
 }
 
+Rational& Rational::operator=(Rational&& number) noexcept {
+    numerator = std::move(number.numerator);
+    denominator = std::move(number.denominator);
+    number.denominator = 1;
+    return *this;
+}
+
 Rational& Rational::operator=(const long long& k) {
     numerator = k;
     denominator = 1;
@@ -197,6 +222,7 @@ Rational& Rational::operator=(const long long& k) {
 Rational& Rational::operator=(const std::pair<long long, long long>& pair) {
     numerator = pair.first;
     denominator = pair.second;
+    this->Simplify();
     return *this;
 }
 
@@ -209,6 +235,7 @@ Rational& Rational::operator=(const BigInt& k) {
 Rational& Rational::operator=(const std::pair<BigInt, BigInt>& pair) {
     numerator = pair.first;
     denominator = pair.second;
+    this->Simplify();
     return *this;
 }
 
@@ -225,42 +252,115 @@ Rational Rational::operator-() const {
 }
 
 // Arithmetics-assignment operators definition
-Rational& Rational::operator+=(const Rational& rhs) {
-    const BigInt gcd = EuclideanAlgorithm(denominator, rhs.denominator);
-    const BigInt c1 = rhs.denominator / gcd;
-    const BigInt c2 = denominator / gcd;
+// Operands are in lowest terms, so each operation cancels common factors
+// before multiplying and does exactly one gcd-based normalization.
+
+// Henrici's addition: with g = gcd(d1, d2), n1/d1 + n2/d2 = t / (d1/g * d2) where
+// t = n1 (d2/g) + n2 (d1/g), and t can only share factors of g with the denominator
+Rational& Rational::AddSigned(const Rational& rhs, bool negate) {
+    if (this == &rhs) {
+        const Rational copy = rhs;
+        return AddSigned(copy, negate);
+    }
 
-    numerator = c1 * numerator + c2 * rhs.numerator;
-    denominator *= c1;
+    static thread_local BigInt divisor, scaled, rhs_scale;
+    divisor = gcd(denominator, rhs.denominator);
+    scaled = rhs.numerator;
+    if (divisor == 1) {
+        // n1 d2 + n2 d1 is already coprime to d1 d2
+        scaled *= denominator;
+        numerator *= rhs.denominator;
+        denominator *= rhs.denominator;
+        if (negate)
+            numerator -= scaled;
+        else
+            numerator += scaled;
+    } else {
+        rhs_scale = rhs.denominator;
+        rhs_scale.divexact(divisor);
+        denominator.divexact(divisor);
+        scaled *= denominator;
+        numerator *= rhs_scale;
+        if (negate)
+            numerator -= scaled;
+        else
+            numerator += scaled;
+
+        divisor = gcd(numerator, divisor);
+        if (divisor != 1) {
+            numerator.divexact(divisor);
+            rhs_scale = rhs.denominator;
+            rhs_scale.divexact(divisor);
+        } else {
+            rhs_scale = rhs.denominator;
+        }
+        denominator *= rhs_scale;
+    }
 
-    this->Simplify();
+    if (numerator == 0)
+        denominator = 1;
     return *this;
 }
 
-Rational& Rational::operator-=(const Rational& rhs) {
-    *this += -rhs;
+Rational& Rational::operator+=(const Rational& rhs) {
+    return AddSigned(rhs, false);
+}
 
-    this->Simplify();
-    return *this;
+Rational& Rational::operator-=(const Rational& rhs) {
+    return AddSigned(rhs, true);
 }
 
+// (n1/d1) (n2/d2) = (n1/g1 * n2/g2) / (d1/g2 * d2/g1) with g1 = gcd(n1, d2), g2 = gcd(n2, d1)
 Rational& Rational::operator*=(const Rational& rhs) {
-    numerator *= rhs.numerator;
-    denominator *= rhs.denominator;
+    if (this == &rhs) {
+        numerator *= numerator;
+        denominator *= denominator;
+        return *this;
+    }
+    if (numerator == 0 || rhs.numerator == 0) {
+        *this = 0;
+        return *this;
+    }
 
-    this->Simplify();
+    const BigInt g1 = gcd(numerator, rhs.denominator);
+    const BigInt g2 = gcd(rhs.numerator, denominator);
+    if (g1 == 1 && g2 == 1) {
+        numerator *= rhs.numerator;
+        denominator *= rhs.denominator;
+        return *this;
+    }
+
+    numerator.divexact(g1);
+    denominator.divexact(g2);
+    numerator *= BigInt(rhs.numerator).divexact(g2);
+    denominator *= BigInt(rhs.denominator).divexact(g1);
     return *this;
 }
 
+// (n1/d1) / (n2/d2) = (n1/g1 * d2/g2) / (d1/g2 * n2/g1) with g1 = gcd(n1, n2), g2 = gcd(d1, d2)
 Rational& Rational::operator/=(const Rational& rhs) {
     if (rhs.numerator == 0) {
         throw;
     }
+    if (this == &rhs) {
+        *this = 1;
+        return *this;
+    }
+    if (numerator == 0) {
+        return *this;
+    }
 
-    numerator *= rhs.denominator;
-    denominator *= rhs.numerator;
+    const BigInt g1 = gcd(numerator, rhs.numerator);
+    const BigInt g2 = gcd(denominator, rhs.denominator);
+    numerator.divexact(g1);
+    denominator.divexact(g2);
+    numerator *= BigInt(rhs.denominator).divexact(g2);
+    denominator *= BigInt(rhs.numerator).divexact(g1);
 
-    this->Simplify();
+    if (denominator < 0) {
+        numerator *= -1;
+        denominator *= -1;
+    }
     return *this;
 }
 
@@ -360,40 +460,62 @@ Rational& Rational::operator/=(const std::pair<BigInt, BigInt>& pair) {
     return *this;
 }
 
+// Fused multiply-subtract definition
+// The product is cross-cancelled into a per-thread buffer and then subtracted by Henrici's method
+Rational& Rational::submul(const Rational& a, const Rational& b) {
+    static thread_local Rational product;
+    product = a;
+    product *= b;
+
+    return AddSigned(product, true);
+}
+
 // Binary arithmetic operators definition
 
-Rational Rational::operator+(const Rational& rhs) const {
+Rational Rational::operator+(const Rational& rhs) const & {
     Rational tmp = *this;
     tmp += rhs;
-
-    tmp.Simplify();
     return tmp;
 }
 
-Rational Rational::operator-(const Rational& rhs) const {
+Rational Rational::operator-(const Rational& rhs) const & {
     Rational tmp = *this;
     tmp -= rhs;
-
-    tmp.Simplify();
     return tmp;
 }
 
-Rational Rational::operator*(const Rational& rhs) const {
+Rational Rational::operator*(const Rational& rhs) const & {
     Rational tmp = *this;
     tmp *= rhs;
-
-    tmp.Simplify();
     return tmp;
 }
 
-Rational Rational::operator/(const Rational& rhs) const {
+Rational Rational::operator/(const Rational& rhs) const & {
     Rational tmp = *this;
     tmp /= rhs;
-
-    tmp.Simplify();
     return tmp;
 }
 
+Rational Rational::operator+(const Rational& rhs) && {
+    *this += rhs;
+    return std::move(*this);
+}
+
+Rational Rational::operator-(const Rational& rhs) && {
+    *this -= rhs;
+    return std::move(*this);
+}
+
+Rational Rational::operator*(const Rational& rhs) && {
+    *this *= rhs;
+    return std::move(*this);
+}
+
+Rational Rational::operator/(const Rational& rhs) && {
+    *this /= rhs;
+    return std::move(*this);
+}
+
 Rational Rational::operator+(const long long& k) const {
     Rational rhs = k;
     return *this + rhs;
@@ -505,17 +627,14 @@ Rational Rational::operator/(const std::pair<BigInt, BigInt>& pair) const {
 }
 
 // Increment Decrement
+// n/d +- 1 = (n +- d)/d stays in lowest terms
 Rational& Rational::operator++() {
     numerator += denominator;
-
-    this->Simplify();
     return *this;
 }
 
 Rational& Rational::operator--() {
     numerator -= denominator;
-
-    this->Simplify();
     return *this;
 }
 
@@ -535,8 +654,9 @@ bool Rational::operator<=(const Rational& rhs) const {
 bool Rational::operator>=(const Rational& rhs) const {
     return !(*this < rhs);
 }
+// lowest terms are unique, so equality needs no multiplication
 bool Rational::operator==(const Rational& rhs) const {
-    return numerator * rhs.denominator == rhs.numerator * denominator;
+    return numerator == rhs.numerator && denominator == rhs.denominator;
 }
 bool Rational::operator!=(const Rational& rhs) const {
     return !(*this == rhs);
@@ -1,4 +1,6 @@
+#pragma once
 #include <algorithm>
+#include <iostream>
 #include <limits.h>
 #include <ostream>
 #include <stdexcept>
@@ -35,10 +37,15 @@ public:
     Tropical(const F& val, const bool inf = false) : val(val), inf(inf) {
     }
 
-    bool IsZero() {
+    bool IsZero() const {
         return inf;
     }
 
+    // The ordinary number behind a finite element
+    const F& Value() const {
+        return val;
+    }
+
 
 
     friend bool operator == <> (const Tropical&, const Tropical&);
@@ -0,0 +1,156 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include "bigint.hpp"
+#include "modular.h"
+
+/*
+    Zp
+    --
+    Element of the prime field Z/pZ, p an odd prime below 2^63. Zp<P> fixes
+    the modulus at compile time; Zp<> (P = 0) reads it from a process-wide
+    modulus set with Zp<>::SetModulus, for primes chosen at run time. Values
+    are stored in Montgomery form, so multiplication needs no division.
+*/
+template<uint64_t P = 0>
+class Zp {
+    static_assert(P == 0 || (P % 2 == 1 && P < (uint64_t(1) << 63)), "Zp modulus must be an odd prime below 2^63");
+
+    uint64_t val;   // Montgomery form, in [0, p)
+
+    static constexpr montgomery fixed_modulus = montgomery(P == 0 ? 1 : P);
+
+    static montgomery& runtime_modulus() {
+        static montgomery m((uint64_t(1) << 61) - 1);
+        return m;
+    }
+
+    static const montgomery& params() {
+        if (P == 0)
+            return runtime_modulus();
+        return fixed_modulus;
+    }
+
+public:
+    Zp() : val(0) {
+    }
+
+    Zp(const long long& num) {
+        const uint64_t p = params().modulus;
+        long long r = num % (long long) p;
+        val = params().to_montgomery(r < 0 ? (uint64_t) r + p : (uint64_t) r);
+    }
+
+    Zp(const BigInt& num) {
+        val = params().to_montgomery(num.residue(params().modulus));
+    }
+
+    // Sets the modulus of Zp<>, shared by all threads so that parallel eliminations see it. Values made under another modulus become meaningless
+    static void SetModulus(uint64_t modulus) {
+        static_assert(P == 0, "the modulus of Zp<P> is fixed");
+        if (modulus % 2 == 0 || modulus >> 63 != 0)
+            throw std::invalid_argument("Zp modulus must be an odd prime below 2^63");
+        runtime_modulus() = montgomery(modulus);
+    }
+
+    static uint64_t Modulus() {
+        return params().modulus;
+    }
+
+    // Least non-negative representative
+    uint64_t Value() const {
+        return params().from_montgomery(val);
+    }
+
+    // x^(-1) * 2^-64 from Euclid is brought back to Montgomery form by two multiplications by 2^128
+    Zp Inverse() const {
+        if (val == 0)
+            throw std::logic_error("Cannot divide by zero");
+        const montgomery& m = params();
+        Zp result;
+        result.val = m.mul(m.mul(inverse_mod(val, m.modulus), m.r_squared), m.r_squared);
+        return result;
+    }
+
+    Zp Pow(uint64_t exp) const {
+        const montgomery& m = params();
+        Zp result = 1, base = *this;
+        for (; exp != 0; exp >>= 1) {
+            if (exp & 1)
+                result.val = m.mul(result.val, base.val);
+            base.val = m.mul(base.val, base.val);
+        }
+        return result;
+    }
+
+    bool operator==(const Zp& rhs) const {
+        return val == rhs.val;
+    }
+
+    bool operator!=(const Zp& rhs) const {
+        return val != rhs.val;
+    }
+
+    Zp operator+() const {
+        return *this;
+    }
+
+    Zp operator-() const {
+        Zp result;
+        result.val = val == 0 ? 0 : params().modulus - val;
+        return result;
+    }
+
+    Zp& operator+=(const Zp& rhs) {
+        val = add_mod(val, rhs.val, params().modulus);
+        return *this;
+    }
+
+    Zp& operator-=(const Zp& rhs) {
+        val = sub_mod(val, rhs.val, params().modulus);
+        return *this;
+    }
+
+    Zp& operator*=(const Zp& rhs) {
+        val = params().mul(val, rhs.val);
+        return *this;
+    }
+
+    Zp& operator/=(const Zp& rhs) {
+        return *this *= rhs.Inverse();
+    }
+
+    Zp operator+(const Zp& rhs) const {
+        return Zp(*this) += rhs;
+    }
+
+    Zp operator-(const Zp& rhs) const {
+        return Zp(*this) -= rhs;
+    }
+
+    Zp operator*(const Zp& rhs) const {
+        return Zp(*this) *= rhs;
+    }
+
+    Zp operator/(const Zp& rhs) const {
+        return Zp(*this) /= rhs;
+    }
+
+    // I/O stream operators:
+    template<uint64_t Q>
+    friend std::ostream& operator<<(std::ostream&, const Zp<Q>&);
+};
+
+template<uint64_t P>
+constexpr montgomery Zp<P>::fixed_modulus;
+
+// Row kernels treat arrays of Zp as arrays of their Montgomery words
+static_assert(sizeof(Zp<>) == sizeof(uint64_t), "Zp must be laid out as a single word");
+
+
+template<uint64_t P>
+std::ostream& operator<<(std::ostream& out, const Zp<P>& num) {
+    out << num.Value();
+    return out;
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROW_KERNELS_X86
+#endif
+
+/*
+    Row update kernels lhs[i] -= coef * rhs[i] for the word-size entry types,
+    with AVX2 and AVX-512 variants chosen at run time from the CPU and a
+    scalar fallback. The vector variants are compiled with target attributes,
+    so no global -mavx flags are needed.
+*/
+
+/*
+    double. The product is rounded before the subtraction, without fused
+    multiply-add, so that every variant gives the same bits as the scalar
+    loop and eliminations stay reproducible across machines and -march flags.
+*/
+__attribute__((optimize("fp-contract=off")))
+void axpy_double_scalar(double* lhs, const double* rhs, double coef, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        lhs[i] -= coef * rhs[i];
+}
+
+/*
+    Residues modulo p < 2^32 stored in 64-bit words. With w < p fixed for
+    the row, Shoup's precomputed quotient w' = floor(w * 2^32 / p) gives
+    q = (x * w') >> 32 within one of floor(x * w / p), so x * w - q * p lies
+    in [0, 2p) and one conditional subtraction reduces it. All products are
+    32 x 32 -> 64 bits, which the vector units multiply natively.
+*/
+void axpy_mod32_scalar(uint64_t* lhs, const uint64_t* rhs, uint64_t w, uint64_t w_shoup, uint64_t p, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t q = (rhs[i] * w_shoup) >> 32;
+        uint64_t product = rhs[i] * w - q * p;
+        if (product >= p)
+            product -= p;
+        lhs[i] = lhs[i] >= product ? lhs[i] - product : lhs[i] + p - product;
+    }
+}
+
+/*
+    Residues modulo p < 2^63, with w' = floor(w * 2^64 / p): the same bound
+    holds, and 2p still fits in a word. The quotient needs the high half of
+    a 64 x 64 bit product, which AVX2 and AVX-512F do not have, and AVX-512
+    IFMA has it only for 52-bit factors, short of the 61-bit primes of
+    ModularRank and Lift. So this kernel stays scalar; it still replaces the
+    128-bit division of mul_mod by two multiplications.
+*/
+void axpy_mod64_scalar(uint64_t* lhs, const uint64_t* rhs, uint64_t w, uint64_t w_shoup, uint64_t p, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t q = (uint64_t) (((unsigned __int128) rhs[i] * w_shoup) >> 64);
+        uint64_t product = rhs[i] * w - q * p;
+        if (product >= p)
+            product -= p;
+        lhs[i] = lhs[i] >= product ? lhs[i] - product : lhs[i] + p - product;
+    }
+}
+
+#ifdef ROW_KERNELS_X86
+
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+void axpy_double_avx2(double* lhs, const double* rhs, double coef, size_t size) {
+    const __m256d c = _mm256_set1_pd(coef);
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d product = _mm256_mul_pd(c, _mm256_loadu_pd(rhs + i));
+        _mm256_storeu_pd(lhs + i, _mm256_sub_pd(_mm256_loadu_pd(lhs + i), product));
+    }
+    axpy_double_scalar(lhs + i, rhs + i, coef, size - i);
+}
+
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+void axpy_double_avx512(double* lhs, const double* rhs, double coef, size_t size) {
+    const __m512d c = _mm512_set1_pd(coef);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m512d product = _mm512_mul_pd(c, _mm512_loadu_pd(rhs + i));
+        _mm512_storeu_pd(lhs + i, _mm512_sub_pd(_mm512_loadu_pd(lhs + i), product));
+    }
+    axpy_double_scalar(lhs + i, rhs + i, coef, size - i);
+}
+
+// Values stay below 2^33, so the signed 64-bit comparisons of AVX2 are exact
+__attribute__((target("avx2")))
+void axpy_mod32_avx2(uint64_t* lhs, const uint64_t* rhs, uint64_t w, uint64_t w_shoup, uint64_t p, size_t size) {
+    const __m256i vw = _mm256_set1_epi64x(w);
+    const __m256i vw_shoup = _mm256_set1_epi64x(w_shoup);
+    const __m256i vp = _mm256_set1_epi64x(p);
+    const __m256i vp_minus_1 = _mm256_set1_epi64x(p - 1);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (rhs + i));
+        __m256i q = _mm256_srli_epi64(_mm256_mul_epu32(x, vw_shoup), 32);
+        __m256i product = _mm256_sub_epi64(_mm256_mul_epu32(x, vw), _mm256_mul_epu32(q, vp));
+        product = _mm256_sub_epi64(product, _mm256_and_si256(_mm256_cmpgt_epi64(product, vp_minus_1), vp));
+        __m256i difference = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*) (lhs + i)), product);
+        difference = _mm256_add_epi64(difference, _mm256_and_si256(_mm256_cmpgt_epi64(zero, difference), vp));
+        _mm256_storeu_si256((__m256i*) (lhs + i), difference);
+    }
+    axpy_mod32_scalar(lhs + i, rhs + i, w, w_shoup, p, size - i);
+}
+
+// GCC 12 fills the unused lanes of the AVX-512 intrinsics with a self-initialized _mm512_undefined_epi32(), which -Wmaybe-uninitialized reports
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f")))
+void axpy_mod32_avx512(uint64_t* lhs, const uint64_t* rhs, uint64_t w, uint64_t w_shoup, uint64_t p, size_t size) {
+    const __m512i vw = _mm512_set1_epi64(w);
+    const __m512i vw_shoup = _mm512_set1_epi64(w_shoup);
+    const __m512i vp = _mm512_set1_epi64(p);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m512i x = _mm512_loadu_si512(rhs + i);
+        __m512i q = _mm512_srli_epi64(_mm512_mul_epu32(x, vw_shoup), 32);
+        __m512i product = _mm512_sub_epi64(_mm512_mul_epu32(x, vw), _mm512_mul_epu32(q, vp));
+        product = _mm512_mask_blend_epi64(_mm512_cmpge_epu64_mask(product, vp), product, _mm512_sub_epi64(product, vp));
+        __m512i y = _mm512_loadu_si512(lhs + i);
+        __m512i difference = _mm512_sub_epi64(y, product);
+        difference = _mm512_mask_blend_epi64(_mm512_cmplt_epu64_mask(y, product), difference, _mm512_add_epi64(difference, vp));
+        _mm512_storeu_si512(lhs + i, difference);
+    }
+    axpy_mod32_scalar(lhs + i, rhs + i, w, w_shoup, p, size - i);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // ROW_KERNELS_X86
+
+enum class simd_level {
+    scalar,
+    avx2,
+    avx512,
+};
+
+// The widest instruction set of the running CPU, detected once
+simd_level detect_simd_level() {
+#ifdef ROW_KERNELS_X86
+    static const simd_level level = __builtin_cpu_supports("avx512f") ? simd_level::avx512
+                                  : __builtin_cpu_supports("avx2") ? simd_level::avx2
+                                  : simd_level::scalar;
+    return level;
+#else
+    return simd_level::scalar;
+#endif
+}
+
+void axpy_double(double* lhs, const double* rhs, double coef, size_t size) {
+#ifdef ROW_KERNELS_X86
+    switch (detect_simd_level()) {
+        case simd_level::avx512:
+            return axpy_double_avx512(lhs, rhs, coef, size);
+        case simd_level::avx2:
+            return axpy_double_avx2(lhs, rhs, coef, size);
+        default:
+            break;
+    }
+#endif
+    axpy_double_scalar(lhs, rhs, coef, size);
+}
+
+// lhs[i] -= w * rhs[i] modulo p < 2^32, for residues rhs[i] < p and lhs[i] < p
+void axpy_mod32(uint64_t* lhs, const uint64_t* rhs, uint64_t w, uint64_t p, size_t size) {
+    const uint64_t w_shoup = (w << 32) / p;
+#ifdef ROW_KERNELS_X86
+    switch (detect_simd_level()) {
+        case simd_level::avx512:
+            return axpy_mod32_avx512(lhs, rhs, w, w_shoup, p, size);
+        case simd_level::avx2:
+            return axpy_mod32_avx2(lhs, rhs, w, w_shoup, p, size);
+        default:
+            break;
+    }
+#endif
+    axpy_mod32_scalar(lhs, rhs, w, w_shoup, p, size);
+}
+
+// lhs[i] -= w * rhs[i] modulo p < 2^63, for residues w, rhs[i] < p and lhs[i] < p: vectorized below 2^32, scalar Shoup above
+void axpy_mod(uint64_t* lhs, const uint64_t* rhs, uint64_t w, uint64_t p, size_t size) {
+    if (p >> 32 == 0)
+        return axpy_mod32(lhs, rhs, w, p, size);
+    const uint64_t w_shoup = (uint64_t) (((unsigned __int128) w << 64) / p);
+    axpy_mod64_scalar(lhs, rhs, w, w_shoup, p, size);
+}